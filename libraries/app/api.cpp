@@ -36,6 +36,7 @@
 #include <fc/time.hpp>
 
 #include <graphene/utilities/key_conversion.hpp>
+#include <graphene/utilities/trace.hpp>
 
 #include <fc/crypto/hex.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -333,4 +334,10 @@ namespace node { namespace app {
        return _app.p2p_node()->set_advanced_node_parameters(params);
     }
 
+    fc::variant network_node_api::get_trace() const
+    {
+       FC_ASSERT( graphene::utilities::tracer::instance().enabled(), "Tracing is disabled, set trace-buffer-size to enable it" );
+       return graphene::utilities::tracer::instance().to_chrome_trace();
+    }
+
 } } // node::app
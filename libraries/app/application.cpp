@@ -25,6 +25,7 @@
 #include <node/app/api_access.hpp>
 #include <node/app/application.hpp>
 #include <node/app/plugin.hpp>
+#include <node/app/transaction_ingestion_queue.hpp>
 
 #include <node/chain/node_objects.hpp>
 #include <node/chain/node_object_types.hpp>
@@ -36,6 +37,7 @@
 #include <graphene/net/exceptions.hpp>
 
 #include <graphene/utilities/key_conversion.hpp>
+#include <graphene/utilities/trace.hpp>
 
 #include <fc/smart_ref_impl.hpp>
 
@@ -133,6 +135,22 @@ namespace detail {
             ilog("Setting p2p max connections to ${n}", ("n", node_param["maximum_number_of_connections"]));
          }
 
+         _p2p_network->set_advanced_node_parameters( fc::variant_object(
+            "connection_worker_threads",
+            fc::variant( _options->at("p2p-worker-threads").as<uint32_t>() ) ) );
+
+         _p2p_network->set_advanced_node_parameters( fc::mutable_variant_object()
+            ( "transaction_push_max_size", _options->at("p2p-trx-push-max-size").as<uint32_t>() )
+            ( "transaction_push_bytes_per_second", _options->at("p2p-trx-push-bytes-per-second").as<uint32_t>() ) );
+
+         _p2p_network->set_advanced_node_parameters( fc::variant_object(
+            "message_cache_max_bytes",
+            fc::variant( uint64_t( _options->at("p2p-message-cache-size-mb").as<uint32_t>() ) * 1024 * 1024 ) ) );
+
+         _p2p_network->set_advanced_node_parameters( fc::variant_object(
+            "cut_through_block_relay",
+            fc::variant( _options->at("p2p-cut-through-block-relay").as<bool>() ) ) );
+
          _p2p_network->listen_to_p2p_network();
          ilog("Configured p2p node to listen on ${ip}", ("ip", _p2p_network->get_actual_listening_endpoint()));
 
@@ -277,6 +295,13 @@ namespace detail {
          if( _options->count( "disable_get_block" ) )
             _self->_disable_get_block = true;
 
+         if( _options->at("trace-buffer-size").as<uint32_t>() )
+         {
+            _trace_file = fc::absolute( _data_dir / _options->at("trace-file").as<string>() );
+            graphene::utilities::tracer::instance().enable( _options->at("trace-buffer-size").as<uint32_t>() );
+            ilog( "Recording trace spans, dump them with SIGUSR2 to ${f} or with get_trace", ("f", _trace_file) );
+         }
+
          if( !read_only )
          {
             _self->_read_only = false;
@@ -286,7 +311,16 @@ namespace detail {
             if( _options->count("resync-blockchain") )
                _chain_db->wipe(_data_dir / "blockchain", _shared_dir, true);
 
-            _chain_db->set_flush_interval( _options->at("flush").as<uint32_t>() );
+            _chain_db->set_flush_interval( _options->at("flush").as<uint32_t>(),
+               _options->at("flush-max-mb-per-second").as<uint32_t>() * uint64_t( 1024 * 1024 ) );
+            _chain_db->set_block_signature_threads( _options->at("block-signature-threads").as<uint32_t>() );
+            _fast_sync_depth = _options->at("fast-sync-depth").as<uint32_t>();
+            if( _fast_sync_depth && _fast_sync_depth < MAX_UNDO_HISTORY )
+            {
+               // Closer to the head a fork could still be switched to, which needs the undo history
+               wlog( "fast-sync-depth ${d} is below the undo history, using ${m}", ("d", _fast_sync_depth)("m", MAX_UNDO_HISTORY) );
+               _fast_sync_depth = MAX_UNDO_HISTORY;
+            }
 
             flat_map<uint32_t,block_id_type> loaded_checkpoints;
             if( _options->count("checkpoint") )
@@ -333,6 +367,14 @@ namespace detail {
                ilog( "All transaction signatures will be validated" );
                _force_validate = true;
             }
+
+            uint32_t trx_queue_threads = _options->at("p2p-trx-queue-threads").as<uint32_t>();
+            if( trx_queue_threads )
+            {
+               ilog( "Checking incoming transactions on ${n} threads", ("n", trx_queue_threads) );
+               _trx_queue.reset( new transaction_ingestion_queue( *_chain_db, trx_queue_threads,
+                  _options->at("p2p-trx-queue-batch-size").as<uint32_t>() ) );
+            }
          }
          else
          {
@@ -443,6 +485,15 @@ namespace detail {
 
          try
          {
+            // items we don't have yet are ruled out by the filters, without waiting for the lock
+            if( id.item_type == graphene::net::block_message_type )
+            {
+               if( !_chain_db->might_know_block(id.item_hash) )
+                  return false;
+            }
+            else if( !_chain_db->might_know_transaction(id.item_hash) )
+               return false;
+
             return _chain_db->with_read_lock( [&]()
             {
                if( id.item_type == graphene::net::block_message_type )
@@ -504,7 +555,11 @@ namespace detail {
                // you can help the network code out by throwing a block_older_than_undo_history exception.
                // when the net code sees that, it will stop trying to push blocks from that chain, but
                // leave that peer connected so that they can get sync blocks from us
-               bool result = _chain_db->push_block(blk_msg.block, (_is_block_producer | _force_validate) ? database::skip_nothing : database::skip_transaction_signatures);
+               uint32_t skip = (_is_block_producer | _force_validate) ? database::skip_nothing : database::skip_transaction_signatures;
+               if( sync_mode && _fast_sync_depth && blk_msg.block.block_num() + _fast_sync_depth <= _sync_target_block_num )
+                  skip |= database::skip_undo_block;
+
+               bool result = _chain_db->push_block(blk_msg.block, skip);
 
                if( !sync_mode )
                {
@@ -537,10 +592,101 @@ namespace detail {
          return false;
       } FC_CAPTURE_AND_RETHROW( (blk_msg)(sync_mode) ) }
 
+      /**
+       * Checks a block that extends our head block without applying it, so it can be relayed while it is
+       * being applied.
+       */
+      virtual void precheck_block(const graphene::net::block_message& blk_msg) override
+      { try {
+         FC_ASSERT( _running );
+
+         uint64_t max_accept_time = time_point_sec( fc::time_point::now() ).sec_since_epoch();
+         max_accept_time += allow_future_time;
+         FC_ASSERT( blk_msg.block.timestamp.sec_since_epoch() <= max_accept_time );
+
+         _chain_db->with_read_lock( [&]()
+         {
+            _chain_db->precheck_block( blk_msg.block );
+         });
+      } FC_CAPTURE_AND_RETHROW( (blk_msg.block_id) ) }
+
+      virtual void handle_blocks(const std::vector<graphene::net::block_message>& blk_msgs,
+                                 std::vector<fc::exception_ptr>& results) override
+      { try {
+         results.clear();
+         results.resize( blk_msgs.size() );
+         if( !_running || blk_msgs.empty() )
+            return;
+
+         fc_ilog(fc::logger::get("sync"),
+               "chain pushing sync blocks #${first} to #${last}",
+               ("first", blk_msgs.front().block.block_num())
+               ("last", blk_msgs.back().block.block_num()));
+
+         uint64_t max_accept_time = time_point_sec( fc::time_point::now() ).sec_since_epoch();
+         max_accept_time += allow_future_time;
+
+         uint32_t skip = (_is_block_producer | _force_validate) ? database::skip_nothing : database::skip_transaction_signatures;
+
+         // Blocks deep enough for fast sync are a prefix of the run, each part is pushed as one batch
+         size_t fast_sync_count = 0;
+         if( _fast_sync_depth )
+            while( fast_sync_count < blk_msgs.size() && blk_msgs[ fast_sync_count ].block.block_num() + _fast_sync_depth <= _sync_target_block_num )
+               ++fast_sync_count;
+
+         auto push_run = [&]( size_t begin, size_t end, uint32_t run_skip )
+         {
+            std::vector< signed_block > blocks;
+            std::vector< size_t > indices;
+            for( size_t i = begin; i < end; ++i )
+            {
+               const auto& block = blk_msgs[i].block;
+               if( block.block_num() % 10000 == 0 )
+                  ilog("Syncing Blockchain --- Got block: #${n} time: ${t}", ("t",block.timestamp)("n", block.block_num()) );
+
+               if( block.timestamp.sec_since_epoch() > max_accept_time )
+               {
+                  results[i] = std::make_shared< fc::assert_exception >( FC_LOG_MESSAGE( error, "Block timestamp is too far in the future",
+                     ("block_num", block.block_num())("timestamp", block.timestamp) ) );
+                  continue;
+               }
+               blocks.push_back( block );
+               indices.push_back( i );
+            }
+
+            std::vector< fc::exception_ptr > block_results;
+            _chain_db->push_blocks( blocks, block_results, run_skip );
+
+            for( size_t j = 0; j < indices.size(); ++j )
+            {
+               if( !block_results[j] )
+                  continue;
+
+               elog("Error when pushing block:\n${e}", ("e", block_results[j]->to_detail_string()));
+               // translate to a graphene::net exception
+               if( block_results[j]->code() == node::chain::unlinkable_block_exception::code_value )
+                  results[ indices[j] ] = std::make_shared< graphene::net::unlinkable_block_exception >(
+                     FC_LOG_MESSAGE( error, "Error when pushing block:\n${e}", ("e", block_results[j]->to_detail_string()) ) );
+               else
+                  results[ indices[j] ] = block_results[j];
+            }
+         };
+
+         if( fast_sync_count )
+            push_run( 0, fast_sync_count, skip | database::skip_undo_block );
+         if( fast_sync_count < blk_msgs.size() )
+            push_run( fast_sync_count, blk_msgs.size(), skip );
+      } FC_CAPTURE_AND_RETHROW( (blk_msgs.size()) ) }
+
       virtual void handle_transaction(const graphene::net::trx_message& transaction_message) override
       { try {
          if( _running )
-            _chain_db->push_transaction( transaction_message.trx );
+         {
+            if( _trx_queue )
+               _trx_queue->push( transaction_message.trx );
+            else
+               _chain_db->push_transaction( transaction_message.trx );
+         }
       } FC_CAPTURE_AND_RETHROW( (transaction_message) ) }
 
       virtual void handle_message(const message& message_to_process) override
@@ -632,16 +778,17 @@ namespace detail {
          // ilog("Request for item ${id}", ("id", id));
          if( id.item_type == graphene::net::block_message_type )
          {
-            return _chain_db->with_read_lock( [&]()
+            // irreversible blocks are framed straight from their bytes in the block log, without decoding them
+            auto packed_block = _chain_db->with_read_lock( [&]()
             {
-               auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
-               if( !opt_block )
+               auto bytes = _chain_db->fetch_block_bytes_by_id(id.item_hash);
+               if( !bytes )
                   elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
                      ("id", id.item_hash)("id2", _chain_db->get_block_id_for_num(block_header::num_from_id(id.item_hash))));
-               FC_ASSERT( opt_block.valid() );
-               // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-               return block_message(std::move(*opt_block));
+               return bytes;
             });
+            FC_ASSERT( packed_block.valid() );
+            return graphene::net::packed_block_message( *packed_block, id.item_hash );
          }
          return _chain_db->with_read_lock( [&]()
          {
@@ -841,6 +988,23 @@ namespace detail {
       virtual void sync_status(uint32_t item_type, uint32_t item_count) override
       {
          // any status reports to GUI go here
+
+         // item_count is what the peers claim they still have to send us. It is not trusted: the
+         // target is capped by the number of blocks that can have been produced since our head
+         if( item_type == graphene::net::block_message_type )
+         {
+            uint32_t head_block_num = 0;
+            fc::time_point_sec head_block_time;
+            _chain_db->with_read_lock( [&]()
+            {
+               head_block_num = _chain_db->head_block_num();
+               head_block_time = _chain_db->head_block_time();
+            });
+
+            int64_t elapsed = ( fc::time_point_sec( fc::time_point::now() ) - head_block_time ).to_seconds();
+            uint64_t max_produced = elapsed > 0 ? uint64_t( elapsed ) / BLOCK_INTERVAL : 0;
+            _sync_target_block_num = head_block_num + uint32_t( std::min< uint64_t >( item_count, max_produced ) );
+         }
       }
 
       /**
@@ -903,6 +1067,8 @@ namespace detail {
       void shutdown()
       {
          _running = false;
+         if( _trx_queue )
+            _trx_queue->close();
          fc::usleep( fc::seconds( 1 ) );
          if( _p2p_network )
          {
@@ -923,6 +1089,7 @@ namespace detail {
       //std::shared_ptr<graphene::db::object_database>   _pending_trx_db;
       std::shared_ptr<node::chain::database>        _chain_db;
       std::shared_ptr<graphene::net::node>             _p2p_network;
+      std::unique_ptr<transaction_ingestion_queue>     _trx_queue;
       std::shared_ptr<fc::http::websocket_server>      _websocket_server;
       std::shared_ptr<fc::http::websocket_tls_server>  _websocket_tls_server;
 
@@ -933,6 +1100,13 @@ namespace detail {
       int32_t                                          _max_block_age = -1;
       uint64_t                                         _shared_file_size;
 
+      /// Sync blocks at least this far below the peers' head are applied as irreversible, 0 disables
+      uint32_t                                         _fast_sync_depth = 0;
+      /// Lower bound of the highest head block offered by peers, from the last sync status
+      uint32_t                                         _sync_target_block_num = 0;
+
+      fc::path                                         _trace_file;
+
       bool                                             _running;
 
       uint32_t allow_future_time = 5;
@@ -979,6 +1153,13 @@ void application::set_program_options(boost::program_options::options_descriptio
    configuration_file_options.add_options()
          ("p2p-endpoint", bpo::value<string>(), "Endpoint for P2P node to listen on")
          ("p2p-max-connections", bpo::value<uint32_t>(), "Maxmimum number of incoming connections on P2P endpoint")
+         ("p2p-worker-threads", bpo::value<uint32_t>()->default_value(GRAPHENE_NET_DEFAULT_CONNECTION_WORKER_THREADS), "Number of threads encrypting, decrypting and compressing large P2P messages. 0 does it on the P2P thread")
+         ("p2p-trx-push-max-size", bpo::value<uint32_t>()->default_value(0), "Push transactions up to this many bytes to peers without advertising them first, for lower relay latency. 0 disables pushing")
+         ("p2p-trx-push-bytes-per-second", bpo::value<uint32_t>()->default_value(GRAPHENE_NET_DEFAULT_TRANSACTION_PUSH_BYTES_PER_SECOND), "Most bytes of pushed transactions sent to each peer per second, the rest is advertised")
+         ("p2p-message-cache-size-mb", bpo::value<uint32_t>()->default_value(GRAPHENE_NET_DEFAULT_MESSAGE_CACHE_MAX_BYTES / (1024*1024)), "Megabytes of recent blocks and transactions kept for serving peers, the oldest are dropped beyond that")
+         ("p2p-cut-through-block-relay", bpo::value<bool>()->default_value(false), "Relay blocks as soon as their header, witness signature and merkle root check out, while they are being applied. Only peers running a version that doesn't disconnect for such a block failing to apply get them early, older peers get them once applied")
+         ("p2p-trx-queue-threads", bpo::value<uint32_t>()->default_value(2), "Number of threads checking incoming P2P transactions before they are pushed in batches. 0 pushes each transaction directly")
+         ("p2p-trx-queue-batch-size", bpo::value<uint32_t>()->default_value(1000), "Maximum number of incoming P2P transactions pushed under a single write lock")
          ("seed-node,s", bpo::value<vector<string>>()->composing(), "P2P nodes to connect to on startup (may specify multiple times)")
          ("checkpoint,c", bpo::value<vector<string>>()->composing(), "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints.")
          ("shared-file-dir", bpo::value<string>(), "Location of the shared memory file. Defaults to data_dir/blockchain")
@@ -992,7 +1173,12 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("public-api", bpo::value< vector<string> >()->composing()->default_value(default_apis, str_default_apis), "Set an API to be publicly available, may be specified multiple times")
          ("enable-plugin", bpo::value< vector<string> >()->composing()->default_value(default_plugins, str_default_plugins), "Plugin(s) to enable, may be specified multiple times")
          ("max-block-age", bpo::value< int32_t >()->default_value(200), "Maximum age of head block when broadcasting tx via API")
-         ("flush", bpo::value< uint32_t >()->default_value(100000), "Flush shared memory file to disk this many blocks")
+         ("flush", bpo::value< uint32_t >()->default_value(100000), "Write the shared memory file back to disk in the background, one pass every this many blocks. 0 leaves it to the OS")
+         ("flush-max-mb-per-second", bpo::value< uint32_t >()->default_value(0), "Maximum rate of the background shared memory write back in MiB/s, 0 for no limit")
+         ("block-signature-threads", bpo::value< uint32_t >()->default_value(0), "Number of threads recovering transaction signatures of incoming blocks in parallel. 0 recovers them while applying the block")
+         ("fast-sync-depth", bpo::value< uint32_t >()->default_value(0), "Apply sync blocks at least this many blocks below the peers' head without undo history or fork database, as when replaying. Raised to the undo history size if lower, 0 disables")
+         ("trace-buffer-size", bpo::value< uint32_t >()->default_value(0), "Record timing spans of block and transaction processing into a ring buffer of this many spans, for get_trace or SIGUSR2. 0 disables")
+         ("trace-file", bpo::value< string >()->default_value("trace.json"), "File the trace is written to on SIGUSR2, relative to the data dir")
          ("backtrace", bpo::value<string>()->default_value("yes"), "Whether to print backtrace on SIGSEGV")
          ;
    command_line_options.add(configuration_file_options);
@@ -1057,6 +1243,13 @@ void application::set_block_production(bool producing_blocks)
    my->_is_block_producer = producing_blocks;
 }
 
+void application::write_trace()const
+{
+   FC_ASSERT( graphene::utilities::tracer::instance().enabled(), "Tracing is disabled, set trace-buffer-size to enable it" );
+   graphene::utilities::tracer::instance().write_chrome_trace( my->_trace_file );
+   ilog( "Wrote trace to ${f}", ("f", my->_trace_file) );
+}
+
 optional< api_access_info > application::get_api_access_info( const string& username )const
 {
    return my->get_api_access_info( username );
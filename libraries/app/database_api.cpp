@@ -326,6 +326,12 @@ reward_fund_api_obj database_api::get_reward_fund( string name )const
    });
 }
 
+shared_memory_flush_stats database_api::get_shared_memory_flush_stats()const
+{
+   // The flusher guards its own stats, no need to hold up writers
+   return my->_db.get_shared_memory_flush_stats();
+}
+
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Keys                                                             //
@@ -870,11 +876,12 @@ set<public_key_type> database_api::get_required_signatures( const signed_transac
 set<public_key_type> database_api_impl::get_required_signatures( const signed_transaction& trx, const flat_set<public_key_type>& available_keys )const
 {
 //   wdump((trx)(available_keys));
+   chain::authority_cache auth_cache( _db );
    auto result = trx.get_required_signatures( CHAIN_ID,
                                               available_keys,
-                                              [&]( string account_name ){ return authority( _db.get< account_authority_object, by_account >( account_name ).active  ); },
-                                              [&]( string account_name ){ return authority( _db.get< account_authority_object, by_account >( account_name ).owner   ); },
-                                              [&]( string account_name ){ return authority( _db.get< account_authority_object, by_account >( account_name ).posting ); },
+                                              auth_cache.active_getter(),
+                                              auth_cache.owner_getter(),
+                                              auth_cache.posting_getter(),
                                               MAX_SIG_CHECK_DEPTH );
 //   wdump((result));
    return result;
@@ -892,29 +899,30 @@ set<public_key_type> database_api_impl::get_potential_signatures( const signed_t
 {
 //   wdump((trx));
    set<public_key_type> result;
+   chain::authority_cache auth_cache( _db );
    trx.get_required_signatures(
       CHAIN_ID,
       flat_set<public_key_type>(),
-      [&]( account_name_type account_name )
+      [&]( const string& account_name ) -> const authority&
       {
-         const auto& auth = _db.get< account_authority_object, by_account >(account_name).active;
-         for( const auto& k : auth.get_keys() )
-            result.insert(k);
-         return authority( auth );
+         const auto& auth = auth_cache.get_active( account_name );
+         for( const auto& k : auth.key_auths )
+            result.insert(k.first);
+         return auth;
       },
-      [&]( account_name_type account_name )
+      [&]( const string& account_name ) -> const authority&
       {
-         const auto& auth = _db.get< account_authority_object, by_account >(account_name).owner;
-         for( const auto& k : auth.get_keys() )
-            result.insert(k);
-         return authority( auth );
+         const auto& auth = auth_cache.get_owner( account_name );
+         for( const auto& k : auth.key_auths )
+            result.insert(k.first);
+         return auth;
       },
-      [&]( account_name_type account_name )
+      [&]( const string& account_name ) -> const authority&
       {
-         const auto& auth = _db.get< account_authority_object, by_account >(account_name).posting;
-         for( const auto& k : auth.get_keys() )
-            result.insert(k);
-         return authority( auth );
+         const auto& auth = auth_cache.get_posting( account_name );
+         for( const auto& k : auth.key_auths )
+            result.insert(k.first);
+         return auth;
       },
       MAX_SIG_CHECK_DEPTH
    );
@@ -933,10 +941,11 @@ bool database_api::verify_authority( const signed_transaction& trx ) const
 
 bool database_api_impl::verify_authority( const signed_transaction& trx )const
 {
+   chain::authority_cache auth_cache( _db );
    trx.verify_authority( CHAIN_ID,
-                         [&]( string account_name ){ return authority( _db.get< account_authority_object, by_account >( account_name ).active  ); },
-                         [&]( string account_name ){ return authority( _db.get< account_authority_object, by_account >( account_name ).owner   ); },
-                         [&]( string account_name ){ return authority( _db.get< account_authority_object, by_account >( account_name ).posting ); },
+                         auth_cache.active_getter(),
+                         auth_cache.owner_getter(),
+                         auth_cache.posting_getter(),
                          MAX_SIG_CHECK_DEPTH );
    return true;
 }
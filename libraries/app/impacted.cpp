@@ -280,6 +280,22 @@ void operation_get_impacted_accounts( const operation& op, flat_set<account_name
    op.visit( vtor );
 }
 
+const chain::impacted_accounts_type& operation_get_impacted_accounts( const chain::operation_notification& note )
+{
+   if( !note.impacted_accounts_valid )
+   {
+      // The visitor needs a flat_set, reuse one so only the inline buffer of the result is touched
+      static thread_local flat_set<account_name_type> impacted;
+      impacted.clear();
+      operation_get_impacted_accounts( note.op, impacted );
+
+      note.impacted_accounts.assign( impacted.begin(), impacted.end() );
+      note.impacted_accounts_valid = true;
+   }
+
+   return note.impacted_accounts;
+}
+
 void transaction_get_impacted_accounts( const transaction& tx, flat_set<account_name_type>& result )
 {
    for( const auto& op : tx.operations )
@@ -163,6 +163,14 @@ namespace node { namespace app {
           */
          std::vector<graphene::net::potential_peer_record> get_potential_peers() const;
 
+         /**
+          * @brief Return the recorded trace spans in the Chrome trace event format
+          *
+          * Requires the node to be started with a nonzero trace-buffer-size. The result can be saved
+          * to a file and opened with chrome://tracing or ui.perfetto.dev.
+          */
+         fc::variant get_trace() const;
+
          /// internal method, not exposed via JSON RPC
          void on_api_startup();
 
@@ -236,6 +244,7 @@ FC_API(node::app::network_node_api,
        (get_potential_peers)
        (get_advanced_node_parameters)
        (set_advanced_node_parameters)
+       (get_trace)
      )
 FC_API(node::app::login_api,
        (login)
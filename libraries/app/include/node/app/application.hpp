@@ -87,6 +87,9 @@ namespace node { namespace app {
          //std::shared_ptr<graphene::db::object_database> pending_trx_database() const;
 
          void set_block_production(bool producing_blocks);
+
+         /// Writes the recorded trace spans to the configured trace-file
+         void write_trace()const;
          fc::optional< api_access_info > get_api_access_info( const string& username )const;
          void set_api_access_info(const string& username, api_access_info&& permissions);
 
@@ -180,6 +180,11 @@ class database_api
       scheduled_hardfork               get_next_scheduled_hardfork()const;
       reward_fund_api_obj              get_reward_fund( string name )const;
 
+      /**
+       * @brief Retrieve the progress of the background write back of the shared memory file
+       */
+      shared_memory_flush_stats        get_shared_memory_flush_stats()const;
+
       //////////
       // Keys //
       //////////
@@ -485,6 +490,7 @@ FC_API(node::app::database_api,
    (get_hardfork_version)
    (get_next_scheduled_hardfork)
    (get_reward_fund)
+   (get_shared_memory_flush_stats)
 
    // Keys
    (get_key_references)
@@ -27,6 +27,7 @@
 #include <node/protocol/operations.hpp>
 #include <node/protocol/transaction.hpp>
 #include <node/chain/node_object_types.hpp>
+#include <node/chain/operation_notification.hpp>
 
 #include <fc/string.hpp>
 
@@ -38,6 +39,12 @@ void operation_get_impacted_accounts(
    const node::protocol::operation& op,
    fc::flat_set<protocol::account_name_type>& result );
 
+/**
+ * Returns the accounts impacted by note.op. The result is computed once and cached on the
+ * notification, so plugins handling the same notification do not repeat the visit.
+ */
+const chain::impacted_accounts_type& operation_get_impacted_accounts( const chain::operation_notification& note );
+
 void transaction_get_impacted_accounts(
    const node::protocol::transaction& tx,
    fc::flat_set<protocol::account_name_type>& result
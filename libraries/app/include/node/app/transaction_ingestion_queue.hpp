@@ -0,0 +1,46 @@
+#pragma once
+
+#include <node/chain/database.hpp>
+
+#include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
+
+namespace node { namespace app {
+
+namespace detail { class transaction_ingestion_queue_impl; }
+
+/**
+ *  Collects transactions arriving from the p2p network and pushes them to the chain in batches.
+ *
+ *  The checks which do not depend on chain state (validate(), size, expiration window, duplicate
+ *  detection against the transactions already in flight and signature recovery) run on a pool of
+ *  worker threads without holding any lock. Transactions that pass are queued, and the queue is
+ *  drained by a single task that pushes everything accumulated so far with one acquisition of the
+ *  database write lock.
+ *
+ *  push() blocks the calling fiber until the transaction has been accepted or rejected, so the
+ *  network layer still receives a result (or exception) per transaction.
+ */
+class transaction_ingestion_queue
+{
+   public:
+      transaction_ingestion_queue( chain::database& db, uint32_t num_threads, uint32_t max_batch_size );
+      ~transaction_ingestion_queue();
+
+      /**
+       *  Checks and pushes a transaction.
+       *  @throws fc::exception if the transaction was rejected by either the stateless checks or the chain.
+       */
+      void push( const chain::signed_transaction& trx );
+
+      /// Stops accepting transactions and fails everything still queued
+      void close();
+
+      /// Number of transactions waiting for the next batch
+      size_t pending_count()const;
+
+   private:
+      std::unique_ptr< detail::transaction_ingestion_queue_impl > my;
+};
+
+} } // node::app
@@ -0,0 +1,264 @@
+#include <node/app/transaction_ingestion_queue.hpp>
+
+#include <node/chain/database_exceptions.hpp>
+
+#include <fc/thread/mutex.hpp>
+#include <fc/thread/scoped_lock.hpp>
+
+#include <boost/scope_exit.hpp>
+
+#include <atomic>
+#include <deque>
+#include <unordered_set>
+
+namespace node { namespace app {
+
+using chain::signed_transaction;
+using protocol::prepared_transaction;
+using protocol::transaction_id_type;
+
+namespace detail {
+
+struct queued_transaction
+{
+   prepared_transaction          trx;
+   fc::promise< void >::ptr      result;
+};
+
+class transaction_ingestion_queue_impl
+{
+   public:
+      transaction_ingestion_queue_impl( chain::database& db, uint32_t num_threads, uint32_t max_batch_size );
+      ~transaction_ingestion_queue_impl();
+
+      void                 push( const signed_transaction& trx );
+      void                 close();
+
+      prepared_transaction check_transaction( const signed_transaction& trx );
+      void                 release_transaction_id( const transaction_id_type& trx_id );
+      void                 flush();
+      void                 complete_batch( const vector< prepared_transaction >& trxs,
+                                           const vector< fc::promise< void >::ptr >& promises,
+                                           const vector< fc::exception_ptr >& results );
+
+      chain::database&                             _db;
+      std::vector< std::shared_ptr< fc::thread > > _thread_pool;
+      uint32_t                                     _next_thread = 0;
+      uint32_t                                     _max_batch_size;
+
+      /// ids of the transactions between the stateless checks and their push result, shared with the worker threads
+      fc::mutex                                    _in_flight_mutex;
+      std::unordered_set< transaction_id_type >    _in_flight;
+
+      std::deque< queued_transaction >             _queue;
+      fc::future< void >                           _flush_done;
+      bool                                         _closed = false;
+
+      /// seconds since epoch of the head block, kept current by _applied_block_connection for the worker threads
+      std::atomic< uint32_t >                      _head_block_time;
+      boost::signals2::scoped_connection           _applied_block_connection;
+};
+
+transaction_ingestion_queue_impl::transaction_ingestion_queue_impl( chain::database& db, uint32_t num_threads, uint32_t max_batch_size )
+   : _db( db ), _max_batch_size( std::max< uint32_t >( max_batch_size, 1 ) )
+{
+   _head_block_time = _db.with_read_lock( [&]() { return _db.head_block_time(); } ).sec_since_epoch();
+   _applied_block_connection = _db.applied_block.connect( [this]( const chain::signed_block& b )
+   {
+      _head_block_time = b.timestamp.sec_since_epoch();
+   });
+
+   _thread_pool.resize( num_threads );
+   for( uint32_t i = 0; i < num_threads; ++i )
+      _thread_pool[i] = std::make_shared< fc::thread >( "trx_check_" + std::to_string( i ) );
+}
+
+transaction_ingestion_queue_impl::~transaction_ingestion_queue_impl()
+{
+   close();
+}
+
+/**
+ * Runs on a worker thread. Nothing here may touch the chain state, so the expiration window is checked
+ * against the time of the last applied block rather than read from the database.
+ */
+prepared_transaction transaction_ingestion_queue_impl::check_transaction( const signed_transaction& trx )
+{
+   trx.validate();
+
+   prepared_transaction result( trx );
+   FC_ASSERT( result.pack_size() <= MAX_BLOCK_SIZE - 256, "Transaction exceeds maximum block size" );
+
+   fc::time_point_sec now( _head_block_time.load() );
+   ASSERT( now < trx.expiration, chain::transaction_expiration_exception,
+      "", ("now", now)("trx.exp", trx.expiration) );
+   ASSERT( trx.expiration <= now + fc::seconds( MAX_TIME_UNTIL_EXPIRATION ), chain::transaction_expiration_exception,
+      "", ("trx.expiration", trx.expiration)("now", now)("max_til_exp", MAX_TIME_UNTIL_EXPIRATION) );
+
+   {
+      fc::scoped_lock< fc::mutex > lock( _in_flight_mutex );
+      FC_ASSERT( _in_flight.insert( result.id() ).second, "Duplicate transaction check failed", ("trx_id", result.id()) );
+   }
+
+   try
+   {
+      result.signature_keys( CHAIN_ID );
+   }
+   catch( ... )
+   {
+      release_transaction_id( result.id() );
+      throw;
+   }
+
+   return result;
+}
+
+void transaction_ingestion_queue_impl::release_transaction_id( const transaction_id_type& trx_id )
+{
+   fc::scoped_lock< fc::mutex > lock( _in_flight_mutex );
+   _in_flight.erase( trx_id );
+}
+
+void transaction_ingestion_queue_impl::push( const signed_transaction& trx )
+{
+   FC_ASSERT( !_closed, "Transaction ingestion queue is closed" );
+
+   fc::optional< prepared_transaction > checked;
+   if( _thread_pool.size() )
+   {
+      auto& worker = _thread_pool[ _next_thread++ % _thread_pool.size() ];
+      checked = worker->async( [&]() { return check_transaction( trx ); }, "check incoming transaction" ).wait();
+   }
+   else
+   {
+      checked = check_transaction( trx );
+   }
+
+   if( _closed )
+   {
+      release_transaction_id( checked->id() );
+      FC_THROW( "Transaction ingestion queue is closed" );
+   }
+
+   fc::promise< void >::ptr result( new fc::promise< void >( "transaction ingestion result" ) );
+   _queue.push_back( queued_transaction{ std::move( *checked ), result } );
+
+   if( !_flush_done.valid() || _flush_done.ready() )
+      _flush_done = fc::async( [this]() { flush(); }, "transaction ingestion flush" );
+
+   fc::future< void >( result ).wait();
+}
+
+/**
+ * Drains the queue in batches of at most _max_batch_size transactions, each pushed with a single
+ * acquisition of the write lock. Transactions queued while a batch is being applied are picked
+ * up by the next iteration.
+ */
+void transaction_ingestion_queue_impl::flush()
+{
+   while( !_queue.empty() )
+   {
+      size_t batch_size = std::min< size_t >( _queue.size(), _max_batch_size );
+
+      vector< prepared_transaction >          trxs;
+      vector< fc::promise< void >::ptr >      promises;
+      trxs.reserve( batch_size );
+      promises.reserve( batch_size );
+
+      for( size_t i = 0; i < batch_size; ++i )
+      {
+         queued_transaction& entry = _queue.front();
+         trxs.push_back( std::move( entry.trx ) );
+         promises.push_back( entry.result );
+         _queue.pop_front();
+      }
+
+      // whatever happens to the batch, its ids leave _in_flight and every caller gets a result
+      vector< fc::exception_ptr > results;
+      BOOST_SCOPE_EXIT( this_, &trxs, &promises, &results ) {
+         this_->complete_batch( trxs, promises, results );
+      } BOOST_SCOPE_EXIT_END
+
+      try
+      {
+         _db.push_transactions( trxs, results );
+      }
+      catch( const fc::exception& e )
+      {
+         results.assign( batch_size, e.dynamic_copy_exception() );
+      }
+      catch( const std::exception& e )
+      {
+         results.assign( batch_size, std::make_shared< fc::std_exception_wrapper >( fc::std_exception_wrapper::from_current_exception( e ) ) );
+      }
+      catch( ... )
+      {
+         results.assign( batch_size, std::make_shared< fc::unhandled_exception >(
+            FC_LOG_MESSAGE( warn, "Unknown exception pushing transaction batch" ), std::current_exception() ) );
+      }
+   }
+}
+
+void transaction_ingestion_queue_impl::complete_batch( const vector< prepared_transaction >& trxs,
+                                                       const vector< fc::promise< void >::ptr >& promises,
+                                                       const vector< fc::exception_ptr >& results )
+{
+   {
+      fc::scoped_lock< fc::mutex > lock( _in_flight_mutex );
+      for( const auto& trx : trxs )
+         _in_flight.erase( trx.id() );
+   }
+
+   for( size_t i = 0; i < promises.size(); ++i )
+   {
+      if( i >= results.size() )
+         promises[i]->set_exception( std::make_shared< fc::exception >( FC_LOG_MESSAGE( warn, "Transaction batch was not pushed" ) ) );
+      else if( results[i] )
+         promises[i]->set_exception( results[i] );
+      else
+         promises[i]->set_value();
+   }
+}
+
+void transaction_ingestion_queue_impl::close()
+{
+   if( _closed )
+      return;
+   _closed = true;
+
+   if( _flush_done.valid() && !_flush_done.ready() )
+      _flush_done.wait();
+
+   // flush() drains the queue completely, so only transactions queued after it exited can be left
+   while( !_queue.empty() )
+   {
+      _queue.front().result->set_exception( std::make_shared< fc::exception >( FC_LOG_MESSAGE( warn, "Transaction ingestion queue is closed" ) ) );
+      _queue.pop_front();
+   }
+
+   _thread_pool.clear();
+}
+
+} // detail
+
+transaction_ingestion_queue::transaction_ingestion_queue( chain::database& db, uint32_t num_threads, uint32_t max_batch_size )
+   : my( new detail::transaction_ingestion_queue_impl( db, num_threads, max_batch_size ) ) {}
+
+transaction_ingestion_queue::~transaction_ingestion_queue() {}
+
+void transaction_ingestion_queue::push( const signed_transaction& trx )
+{
+   my->push( trx );
+}
+
+void transaction_ingestion_queue::close()
+{
+   my->close();
+}
+
+size_t transaction_ingestion_queue::pending_count()const
+{
+   return my->_queue.size();
+}
+
+} } // node::app
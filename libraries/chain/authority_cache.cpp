@@ -0,0 +1,38 @@
+#include <node/chain/authority_cache.hpp>
+#include <node/chain/database.hpp>
+#include <node/chain/account_object.hpp>
+
+namespace node { namespace chain {
+
+const authority& authority_cache::get( const account_name_type& account,
+   fc::optional< authority > entry::* level, const shared_authority account_authority_object::* stored )
+{
+   auto itr = _entries.find( account );
+   if( itr != _entries.end() && ( itr->second.*level ).valid() )
+      return *( itr->second.*level );
+
+   const auto& auth = _db.get< account_authority_object, by_account >( account );
+   if( itr == _entries.end() )
+      itr = _entries.emplace( account, entry() ).first;
+
+   auto& cached = itr->second.*level;
+   cached = authority( auth.*stored );
+   return *cached;
+}
+
+const authority& authority_cache::get_active( const account_name_type& account )
+{
+   return get( account, &entry::active, &account_authority_object::active );
+}
+
+const authority& authority_cache::get_owner( const account_name_type& account )
+{
+   return get( account, &entry::owner, &account_authority_object::owner );
+}
+
+const authority& authority_cache::get_posting( const account_name_type& account )
+{
+   return get( account, &entry::posting, &account_authority_object::posting );
+}
+
+} } // node::chain
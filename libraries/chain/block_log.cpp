@@ -1,6 +1,7 @@
 #include <node/chain/block_log.hpp>
 #include <fstream>
 #include <fc/io/raw.hpp>
+#include <graphene/utilities/trace.hpp>
 
 #define LOG_READ  (std::ios::in | std::ios::binary)
 #define LOG_WRITE (std::ios::out | std::ios::binary | std::ios::app)
@@ -183,16 +184,21 @@ namespace node { namespace chain {
    }
 
    uint64_t block_log::append( const signed_block& b )
+   {
+      return append( b, fc::raw::pack( b ) );
+   }
+
+   uint64_t block_log::append( const signed_block& b, const vector< char >& data )
    {
       try
       {
+         TRACE_SPAN( "block_log::append", b.block_num() );
          my->check_block_write();
          my->check_index_write();
 
          uint64_t pos = my->block_stream.tellp();
          uint64_t index_pos = my->index_stream.tellp();
          FC_ASSERT( index_pos == sizeof( uint64_t ) * uint64_t( b.block_num() - 1 ), "Append to index file occuring at wrong position.", ( "position", (uint64_t) my->index_stream.tellp() )( "expected",( b.block_num() - 1 ) * sizeof( uint64_t ) ) );
-         auto data = fc::raw::pack( b );
          my->block_stream.write( data.data(), data.size() );
          my->block_stream.write( (char*)&pos, sizeof( pos ) );
          my->index_stream.write( (char*)&pos, sizeof( pos ) );
@@ -206,6 +212,7 @@ namespace node { namespace chain {
 
    void block_log::flush()
    {
+      TRACE_SPAN( "block_log::flush" );
       my->block_stream.flush();
       my->index_stream.flush();
    }
@@ -241,6 +248,39 @@ namespace node { namespace chain {
       FC_LOG_AND_RETHROW()
    }
 
+   vector< char > block_log::read_block_bytes_by_num( uint32_t block_num )const
+   {
+      try
+      {
+         vector< char > data;
+         uint64_t pos = get_block_pos( block_num );
+         if( pos == npos )
+            return data;
+
+         // Every block is followed by its 8 byte position, so it ends 8 bytes before the next block
+         // starts, or 8 bytes before the end of the file for the head block.
+         uint64_t end_pos;
+         if( block_num == protocol::block_header::num_from_id( my->head_id ) )
+         {
+            my->check_block_read();
+            my->block_stream.seekg( 0, std::ios::end );
+            end_pos = uint64_t( my->block_stream.tellg() ) - sizeof( uint64_t );
+         }
+         else
+         {
+            end_pos = get_block_pos( block_num + 1 ) - sizeof( uint64_t );
+         }
+         FC_ASSERT( end_pos > pos, "Invalid block position in block log index.", ("block_num", block_num)("pos", pos)("end_pos", end_pos) );
+
+         my->check_block_read();
+         data.resize( end_pos - pos );
+         my->block_stream.seekg( pos );
+         my->block_stream.read( data.data(), data.size() );
+         return data;
+      }
+      FC_LOG_AND_RETHROW()
+   }
+
    uint64_t block_log::get_block_pos( uint32_t block_num ) const
    {
       try
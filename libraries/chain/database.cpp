@@ -68,6 +68,11 @@ namespace node { namespace chain {
 
 using boost::container::flat_set;
 
+/// over two days of blocks, and an hour of 300 transactions per second, per filter generation
+const uint32_t KNOWN_BLOCK_FILTER_CAPACITY            = 1 << 16;
+const uint32_t KNOWN_TRANSACTION_FILTER_CAPACITY      = 1 << 20;
+const uint32_t KNOWN_TRANSACTION_FILTER_SLACK_SECONDS = 10 * 60;
+
 struct reward_fund_context
 {
    uint128_t   recent_claims = 0;
@@ -88,7 +93,8 @@ database_impl::database_impl( database& self )
    : _self(self), _evaluator_registry(self) {}
 
 database::database()
-   : _my( new database_impl(*this) ) {}
+   : _my( new database_impl(*this) ), _state_flusher( *this ), _authority_cache( *this ),
+     _known_block_filter( KNOWN_BLOCK_FILTER_CAPACITY ), _known_transaction_filter( KNOWN_TRANSACTION_FILTER_CAPACITY ) {}
 
 database::~database()
 {
@@ -102,6 +108,10 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
       init_schema();
       chainbase::database::open( shared_mem_dir, chainbase_flags, shared_file_size );
 
+      // This assertion should be caught and a reindex should occur
+      FC_ASSERT( !is_dirty(), "Shared memory file was not closed cleanly, it must be rebuilt from the block log. Please reindex blockchain.",
+         ("shared_mem_dir", shared_mem_dir) );
+
       initialize_indexes();
       initialize_evaluators();
 
@@ -114,6 +124,7 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
             });
 
          _block_log.open( data_dir / "block_log" );
+         _fork_db_file = data_dir / "fork_db";
 
          auto log_head = _block_log.head();
 
@@ -134,6 +145,13 @@ void database::open( const fc::path& data_dir, const fc::path& shared_mem_dir, u
 
             _fork_db.start_block( *head_block );
          }
+         reset_known_id_filters();
+
+         if( head_block_num() )
+            reapply_saved_fork_blocks();
+
+         if( _flush_blocks )
+            _state_flusher.start( fc::seconds( int64_t( _flush_blocks ) * BLOCK_INTERVAL ), _flush_max_bytes_per_second );
       }
 
       with_read_lock( [&]()
@@ -190,8 +208,12 @@ void database::reindex( const fc::path& data_dir, const fc::path& shared_mem_dir
          set_revision( head_block_num() );
       });
 
+      reset_known_id_filters();
       if( _block_log.head()->block_num() )
+      {
          _fork_db.start_block( *_block_log.head() );
+         reapply_saved_fork_blocks();
+      }
 
       auto end = fc::time_point::now();
       ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
@@ -200,6 +222,54 @@ void database::reindex( const fc::path& data_dir, const fc::path& shared_mem_dir
 
 }
 
+/**
+ * Pushes the reversible blocks saved by the last close() on top of the irreversible state, so
+ * the node is back at its previous head without refetching them. The blocks go through
+ * push_block() with full validation, blocks on minority forks end up in the fork database as
+ * they originally did. Blocks that no longer link are dropped.
+ */
+void database::reapply_saved_fork_blocks()
+{
+   if( _fork_db_file.empty() || !fc::exists( _fork_db_file ) )
+      return;
+
+   vector< signed_block > blocks;
+   try
+   {
+      blocks = fork_database::load( _fork_db_file );
+   }
+   catch( const fc::exception& e )
+   {
+      wlog( "Discarding unreadable fork database file: ${e}", ("e", e.to_detail_string()) );
+   }
+   fc::remove( _fork_db_file );
+
+   if( blocks.empty() )
+      return;
+
+   ilog( "Reapplying ${n} reversible blocks from ${first} to ${last}",
+      ("n", blocks.size())("first", blocks.front().block_num())("last", blocks.back().block_num()) );
+
+   uint32_t applied = 0;
+   for( const auto& b : blocks )
+   {
+      if( b.block_num() <= head_block_num() && is_known_block( b.id() ) )
+         continue;
+
+      try
+      {
+         push_block( b );
+         ++applied;
+      }
+      catch( const fc::exception& e )
+      {
+         wlog( "Dropping saved block ${n} ${id}: ${e}", ("n", b.block_num())("id", b.id())("e", e.to_string()) );
+      }
+   }
+
+   ilog( "Reapplied ${n} blocks, head is now ${h}", ("n", applied)("h", head_block_num()) );
+}
+
 void database::wipe( const fc::path& data_dir, const fc::path& shared_mem_dir, bool include_blocks)
 {
    close();
@@ -208,6 +278,7 @@ void database::wipe( const fc::path& data_dir, const fc::path& shared_mem_dir, b
    {
       fc::remove_all( data_dir / "block_log" );
       fc::remove_all( data_dir / "block_log.index" );
+      fc::remove_all( data_dir / "fork_db" );
    }
 }
 
@@ -220,6 +291,21 @@ void database::close(bool rewind)
       // DB state (issue #336).
       clear_pending();
 
+      _state_flusher.stop();
+
+      if( _fork_db.head() && !_fork_db_file.empty() )
+      {
+         try
+         {
+            uint32_t lib = with_read_lock( [&]() { return last_non_undoable_block_num(); } );
+            _fork_db.save( _fork_db_file, lib );
+         }
+         catch( const fc::exception& e )
+         {
+            wlog( "Unable to save fork database, reversible blocks will be fetched from peers: ${e}", ("e", e.to_detail_string()) );
+         }
+      }
+
       chainbase::database::flush();
       chainbase::database::close();
 
@@ -232,9 +318,37 @@ void database::close(bool rewind)
 
 bool database::is_known_block( const block_id_type& id )const
 { try {
-   return fetch_block_by_id( id ).valid();
+   if( _fork_db.fetch_block( id ) )
+      return true;
+
+   auto data = _block_log.read_block_bytes_by_num( protocol::block_header::num_from_id( id ) );
+   return data.size() && protocol::signed_block_view( data ).id() == id;
 } FC_CAPTURE_AND_RETHROW() }
 
+bool database::might_know_block( const block_id_type& id )const
+{
+   return !_known_block_filter.excludes( id, protocol::block_header::num_from_id( id ) );
+}
+
+/**
+ * A transaction still in the dupe check index was applied at most MAX_TIME_UNTIL_EXPIRATION before
+ * its expiration, so before the current head block time minus that.  The slack covers the head
+ * moving back when switching forks.
+ */
+bool database::might_know_transaction( const transaction_id_type& id )const
+{
+   const uint64_t window = MAX_TIME_UNTIL_EXPIRATION + KNOWN_TRANSACTION_FILTER_SLACK_SECONDS;
+   uint64_t last = _known_transaction_filter.last_mark();
+   return last < window || !_known_transaction_filter.excludes( id, last - window );
+}
+
+void database::reset_known_id_filters()
+{
+   // everything known before this point is only found by the exact checks
+   _known_block_filter.reset( head_block_num() + 1 );
+   _known_transaction_filter.reset( head_block_time().sec_since_epoch() + 1 );
+}
+
 /**
  * Only return true *if* the transaction has not expired or been invalidated. If this
  * method is called with a VERY old transaction we will return false, they should
@@ -316,15 +430,71 @@ optional<signed_block> database::fetch_block_by_number( uint32_t block_num )cons
    return b;
 } FC_LOG_AND_RETHROW() }
 
+optional< vector< char > > database::fetch_block_bytes_by_id( const block_id_type& id )const
+{ try {
+   optional< vector< char > > result;
+
+   auto b = _fork_db.fetch_block( id );
+   if( b )
+   {
+      result = b->packed.empty() ? fc::raw::pack( b->data ) : b->packed;
+      return result;
+   }
+
+   auto data = _block_log.read_block_bytes_by_num( protocol::block_header::num_from_id( id ) );
+   if( data.size() && protocol::signed_block_view( data ).id() == id )
+      result = std::move( data );
+
+   return result;
+} FC_CAPTURE_AND_RETHROW() }
+
+optional< vector< char > > database::fetch_block_bytes_by_number( uint32_t block_num )const
+{ try {
+   optional< vector< char > > result;
+
+   auto results = _fork_db.fetch_block_by_number( block_num );
+   if( results.size() == 1 )
+   {
+      result = results[0]->packed.empty() ? fc::raw::pack( results[0]->data ) : results[0]->packed;
+      return result;
+   }
+
+   auto data = _block_log.read_block_bytes_by_num( block_num );
+   if( data.size() )
+      result = std::move( data );
+
+   return result;
+} FC_LOG_AND_RETHROW() }
+
 const signed_transaction database::get_recent_transaction( const transaction_id_type& trx_id ) const
 { try {
    auto& index = get_index<transaction_index>().indices().get<by_trx_id>();
    auto itr = index.find(trx_id);
    FC_ASSERT(itr != index.end());
-   signed_transaction trx;
-   fc::raw::unpack( itr->packed_trx, trx );
-   return trx;;
-} FC_CAPTURE_AND_RETHROW() }
+
+   // the id is only checked, not searched for, so serving a transaction costs one hash
+   if( itr->block_num > head_block_num() )
+   {
+      if( itr->trx_in_block < _pending_tx.size() && _pending_tx[ itr->trx_in_block ].id() == trx_id )
+         return _pending_tx[ itr->trx_in_block ];
+   }
+   else
+   {
+      // the block on our chain at that height, there may be other blocks at it in the fork database
+      optional< signed_block > block;
+      auto item = _fork_db.fetch_block_on_main_branch_by_number( itr->block_num );
+      if( item )
+         block = item->data;
+      else
+         block = _block_log.read_block_by_num( itr->block_num );
+
+      if( block.valid() && itr->trx_in_block < block->transactions.size() &&
+          block->transactions[ itr->trx_in_block ].id() == trx_id )
+         return block->transactions[ itr->trx_in_block ];
+   }
+
+   FC_THROW( "Transaction ${trx_id} is no longer available", ("trx_id", trx_id) );
+} FC_CAPTURE_AND_RETHROW( (trx_id) ) }
 
 std::vector< block_id_type > database::get_block_ids_on_fork( block_id_type head_of_fork ) const
 { try {
@@ -503,22 +673,49 @@ bool database::before_last_checkpoint()const
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
    //fc::time_point begin_time = fc::time_point::now();
+   TRACE_SPAN( "push_block", new_block.block_num() );
+
+   // Packing, hashing and signature recovery only depend on the block itself, so do them in parallel before the write lock
+   // is taken. _apply_block picks the results up by block id, blocks applied without them (e.g. during a fork switch) are
+   // prepared serially.
+   block_id_type new_block_id;
+   bool prepare_transactions = _block_signature_threads.size() && new_block.transactions.size() > 1;
+   if( prepare_transactions )
+   {
+      bool recover_keys = !( ( skip | get_node_properties().skip_flags ) & ( skip_transaction_signatures | skip_authority_check ) );
+      new_block_id = new_block.id();
+      // preparing yields this fiber, so don't hold a reference into the map across it
+      vector< prepared_transaction > prepared = prepare_block_transactions( new_block, recover_keys );
+      _prepared_block_transactions[ new_block_id ] = std::move( prepared );
+   }
 
    bool result;
-   detail::with_skip_flags( *this, skip, [&]()
+   try
    {
-      with_write_lock( [&]()
+      detail::with_skip_flags( *this, skip, [&]()
       {
-         detail::without_pending_transactions( *this, std::move(_pending_tx), [&]()
+         with_write_lock( [&]()
          {
-            try
+            detail::without_pending_transactions( *this, std::move(_pending_tx), [&]()
             {
-               result = _push_block(new_block);
-            }
-            FC_CAPTURE_AND_RETHROW( (new_block) )
+               try
+               {
+                  result = _push_block(new_block);
+               }
+               FC_CAPTURE_AND_RETHROW( (new_block) )
+            });
          });
       });
-   });
+   }
+   catch( ... )
+   {
+      if( prepare_transactions )
+         _prepared_block_transactions.erase( new_block_id );
+      throw;
+   }
+
+   if( prepare_transactions )
+      _prepared_block_transactions.erase( new_block_id );
 
    //fc::time_point end_time = fc::time_point::now();
    //fc::microseconds dt = end_time - begin_time;
@@ -527,6 +724,68 @@ bool database::push_block(const signed_block& new_block, uint32_t skip)
    return result;
 }
 
+void database::push_blocks( const vector< signed_block >& blocks, vector< fc::exception_ptr >& results, uint32_t skip )
+{
+   TRACE_SPAN( "push_blocks", int64_t( blocks.size() ) );
+   results.clear();
+   results.resize( blocks.size() );
+   if( blocks.empty() )
+      return;
+
+   vector< block_id_type > prepared_block_ids;
+   try
+   {
+      if( _block_signature_threads.size() )
+      {
+         bool recover_keys = !( ( skip | get_node_properties().skip_flags ) & ( skip_transaction_signatures | skip_authority_check ) );
+         for( const auto& b : blocks )
+         {
+            if( b.transactions.size() > 1 )
+            {
+               // preparing yields this fiber, so don't hold a reference into the map across it
+               vector< prepared_transaction > prepared = prepare_block_transactions( b, recover_keys );
+               prepared_block_ids.push_back( b.id() );
+               _prepared_block_transactions[ prepared_block_ids.back() ] = std::move( prepared );
+            }
+         }
+      }
+
+      detail::with_skip_flags( *this, skip, [&]()
+      {
+         with_write_lock( [&]()
+         {
+            detail::without_pending_transactions( *this, std::move(_pending_tx), [&]()
+            {
+               for( size_t i = 0; i < blocks.size(); ++i )
+               {
+                  try
+                  {
+                     try
+                     {
+                        _push_block( blocks[i] );
+                     }
+                     FC_CAPTURE_AND_RETHROW( (blocks[i]) )
+                  }
+                  catch( const fc::exception& e )
+                  {
+                     results[i] = e.dynamic_copy_exception();
+                  }
+               }
+            });
+         });
+      });
+   }
+   catch( ... )
+   {
+      for( const auto& id : prepared_block_ids )
+         _prepared_block_transactions.erase( id );
+      throw;
+   }
+
+   for( const auto& id : prepared_block_ids )
+      _prepared_block_transactions.erase( id );
+}
+
 void database::_maybe_warn_multiple_production( uint32_t height )const
 {
    auto blocks = _fork_db.fetch_block_by_number( height );
@@ -546,11 +805,27 @@ void database::_maybe_warn_multiple_production( uint32_t height )const
 bool database::_push_block(const signed_block& new_block)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
-   //uint32_t skip_undo_db = skip & skip_undo_block;
+
+   // known from here on, whether it ends up in the fork database or straight in the block log
+   _known_block_filter.insert( new_block.id(), new_block.block_num() );
+
+   if( skip & skip_undo_block )
+   {
+      _push_irreversible_block( new_block );
+      return false;
+   }
 
    if( !(skip&skip_fork_db) )
    {
-      shared_ptr<fork_item> new_head = _fork_db.push_block(new_block);
+      // The fork database is dropped while blocks are applied as irreversible, restart it from head
+      if( !_fork_db.head() && head_block_num() )
+      {
+         auto head_block = fetch_block_by_number( head_block_num() );
+         FC_ASSERT( head_block.valid(), "Head block is missing from the block log", ("head", head_block_num()) );
+         _fork_db.start_block( *head_block );
+      }
+
+      shared_ptr<fork_item> new_head = _fork_db.push_block(new_block, pack_prepared_block(new_block));
       _maybe_warn_multiple_production( new_head->num );
 
       //If the head block from the longest chain does not build off of the current head, we need to switch forks.
@@ -627,6 +902,46 @@ bool database::_push_block(const signed_block& new_block)
    return false;
 } FC_CAPTURE_AND_RETHROW() }
 
+/**
+ * Applies a block that is known to be far below the network's head as irreversible: without the
+ * fork database and committed as soon as it is applied, so it cannot be popped again. The
+ * reversible blocks applied before it are made irreversible first, there is no undoing past this
+ * point, so callers must only use it for blocks that cannot be forked out.
+ */
+void database::_push_irreversible_block( const signed_block& new_block )
+{
+   ASSERT( new_block.previous == head_block_id(), unlinkable_block_exception, "block does not link to head block",
+      ("block", new_block.block_num())("previous", new_block.previous)("head", head_block_id()) );
+
+   if( _fork_db.head() )
+   {
+      uint32_t log_head_num = _block_log.head() ? _block_log.head()->block_num() : 0;
+      for( uint32_t num = log_head_num + 1; num <= head_block_num(); ++num )
+      {
+         shared_ptr< fork_item > block = _fork_db.fetch_block_on_main_branch_by_number( num );
+         FC_ASSERT( block, "Current fork in the fork database does not contain reversible block ${n}", ("n", num) );
+         append_to_block_log( *block );
+      }
+      commit( head_block_num() );
+      _fork_db.reset();
+   }
+
+   // The block still comes from a peer, an invalid one must leave the state at head untouched
+   {
+      auto session = start_undo_session( true );
+      apply_block( new_block, get_node_properties().skip_flags | skip_block_log | skip_undo_history_check );
+      session.push();
+   }
+   commit( head_block_num() );
+
+   vector< char > packed = pack_prepared_block( new_block );
+   if( packed.empty() )
+      _block_log.append( new_block );
+   else
+      _block_log.append( new_block, packed );
+   _block_log.flush();
+}
+
 /**
  * Attempts to push the transaction into the pending queue
  *
@@ -638,18 +953,20 @@ bool database::_push_block(const signed_block& new_block)
  */
 void database::push_transaction( const signed_transaction& trx, uint32_t skip )
 {
+   TRACE_SPAN( "push_transaction" );
    try
    {
       try
       {
-         FC_ASSERT( fc::raw::pack_size(trx) <= (get_dynamic_global_properties().maximum_block_size - 256) );
+         auto ptrx = prepared_transaction::borrow( trx );
+         FC_ASSERT( ptrx.pack_size() <= (get_dynamic_global_properties().maximum_block_size - 256) );
          set_producing( true );
          detail::with_skip_flags( *this, skip,
             [&]()
             {
                with_write_lock( [&]()
                {
-                  _push_transaction( trx );
+                  _push_transaction( ptrx );
                });
             });
          set_producing( false );
@@ -663,7 +980,62 @@ void database::push_transaction( const signed_transaction& trx, uint32_t skip )
    FC_CAPTURE_AND_RETHROW( (trx) )
 }
 
+void database::push_transactions( const vector< prepared_transaction >& trxs,
+                                  vector< fc::exception_ptr >& results,
+                                  uint32_t skip )
+{
+   TRACE_SPAN( "push_transactions", int64_t( trxs.size() ) );
+   results.clear();
+   results.resize( trxs.size() );
+   if( trxs.empty() )
+      return;
+
+   try
+   {
+      set_producing( true );
+      detail::with_skip_flags( *this, skip,
+         [&]()
+         {
+            with_write_lock( [&]()
+            {
+               for( size_t i = 0; i < trxs.size(); ++i )
+               {
+                  try
+                  {
+                     FC_ASSERT( trxs[i].pack_size() <= (get_dynamic_global_properties().maximum_block_size - 256) );
+                     _push_transaction( trxs[i] );
+                  }
+                  catch( const fc::exception& e )
+                  {
+                     results[i] = e.dynamic_copy_exception();
+                  }
+                  catch( const std::exception& e )
+                  {
+                     results[i] = std::make_shared< fc::std_exception_wrapper >( fc::std_exception_wrapper::from_current_exception( e ) );
+                  }
+                  catch( ... )
+                  {
+                     results[i] = std::make_shared< fc::unhandled_exception >(
+                        FC_LOG_MESSAGE( warn, "Unknown exception pushing transaction ${id}", ("id", trxs[i].id()) ), std::current_exception() );
+                  }
+               }
+            });
+         });
+      set_producing( false );
+   }
+   catch( ... )
+   {
+      set_producing( false );
+      throw;
+   }
+}
+
 void database::_push_transaction( const signed_transaction& trx )
+{
+   _push_transaction( prepared_transaction::borrow( trx ) );
+}
+
+void database::_push_transaction( const prepared_transaction& trx )
 {
    // If this is the first transaction pushed after applying a block, start a new undo session.
    // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
@@ -676,15 +1048,18 @@ void database::_push_transaction( const signed_transaction& trx )
    // apply the changes.
 
    auto temp_session = start_undo_session( true );
+   _deferred_operations.clear();
+   _current_trx_in_block = _pending_tx.size();
    _apply_transaction( trx );
-   _pending_tx.push_back( trx );
+   notify_deferred_apply_operations();
+   _pending_tx.push_back( *trx );
 
    notify_changed_objects();
    // The transaction applied successfully. Merge its changes into the pending block session.
    temp_session.squash();
 
    // notify anyone listening to pending transactions
-   notify_on_pending_transaction( trx );
+   notify_on_pending_transaction( *trx );
 }
 
 signed_block database::generate_block(
@@ -694,6 +1069,7 @@ signed_block database::generate_block(
    uint32_t skip /* = 0 */
    )
 {
+   TRACE_SPAN( "generate_block" );
    signed_block result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -782,7 +1158,8 @@ signed_block database::_generate_block(
          if( tx.expiration < when )
             continue;
 
-         uint64_t new_total_size = total_block_size + fc::raw::pack_size( tx );
+         auto ptrx = prepared_transaction::borrow( tx );
+         uint64_t new_total_size = total_block_size + ptrx.pack_size();
 
          // postpone transaction if it would make block too big
          if( new_total_size >= maximum_block_size )
@@ -794,10 +1171,10 @@ signed_block database::_generate_block(
          try
          {
             auto temp_session = start_undo_session( true );
-            _apply_transaction( tx );
+            _apply_transaction( ptrx );
             temp_session.squash();
 
-            total_block_size += fc::raw::pack_size( tx );
+            total_block_size = new_total_size;
             pending_block.transactions.push_back( tx );
          }
          catch ( const fc::exception& e )
@@ -880,11 +1257,111 @@ void database::notify_pre_apply_operation( operation_notification& note )
    note.op_in_trx    = _current_op_in_trx;
 
    TRY_NOTIFY( pre_apply_operation, note )
+   dispatch_operation( _pre_apply_operation_handlers, note );
+
+   if( has_deferred_operation_subscribers( note.op ) )
+   {
+      note.deferred_index = _deferred_operations.size();
+      _deferred_operations.emplace_back( note );
+   }
 }
 
 void database::notify_post_apply_operation( const operation_notification& note )
 {
    TRY_NOTIFY( post_apply_operation, note )
+   dispatch_operation( _post_apply_operation_handlers, note );
+
+   // impacted accounts computed by a pre or post apply handler are not computed again for the deferred handlers
+   if( note.impacted_accounts_valid && note.deferred_index >= 0 && size_t( note.deferred_index ) < _deferred_operations.size() )
+   {
+      auto& deferred = _deferred_operations[ note.deferred_index ];
+      if( !deferred.impacted_accounts_valid )
+      {
+         deferred.impacted_accounts = note.impacted_accounts;
+         deferred.impacted_accounts_valid = true;
+      }
+   }
+}
+
+void database::subscribe_pre_apply_operation( const vector< int64_t >& op_tags, const operation_handler& handler )
+{
+   subscribe_operation_handler( _pre_apply_operation_handlers, op_tags, handler );
+}
+
+void database::subscribe_post_apply_operation( const vector< int64_t >& op_tags, const operation_handler& handler )
+{
+   subscribe_operation_handler( _post_apply_operation_handlers, op_tags, handler );
+}
+
+void database::subscribe_deferred_apply_operation( const vector< int64_t >& op_tags, const operation_handler& handler )
+{
+   subscribe_operation_handler( _deferred_apply_operation_handlers, op_tags, handler );
+}
+
+void database::subscribe_operation_handler( operation_dispatch_table& table, const vector< int64_t >& op_tags, const operation_handler& handler )
+{
+   if( table.empty() )
+      table.resize( operation::count() );
+
+   for( auto tag : op_tags )
+   {
+      FC_ASSERT( tag >= 0 && tag < int64_t( table.size() ), "Invalid operation tag", ("tag", tag) );
+      table[ tag ].push_back( handler );
+   }
+}
+
+void database::dispatch_operation( const operation_dispatch_table& table, const operation_notification& note )
+{
+   size_t which = note.op.which();
+   if( which >= table.size() )
+      return;
+
+   for( const auto& handler : table[ which ] )
+   {
+      TRY_NOTIFY( handler, note )
+   }
+}
+
+bool database::has_deferred_operation_subscribers( const operation& op )const
+{
+   size_t which = op.which();
+   return !deferred_apply_operation.empty()
+      || ( which < _deferred_apply_operation_handlers.size() && _deferred_apply_operation_handlers[ which ].size() );
+}
+
+bool database::has_operation_subscribers( const operation& op )const
+{
+   if( !pre_apply_operation.empty() || !post_apply_operation.empty() )
+      return true;
+
+   size_t which = op.which();
+   return ( which < _pre_apply_operation_handlers.size() && _pre_apply_operation_handlers[ which ].size() )
+      || ( which < _post_apply_operation_handlers.size() && _post_apply_operation_handlers[ which ].size() )
+      || has_deferred_operation_subscribers( op );
+}
+
+void database::notify_deferred_apply_operations()
+{
+   if( _deferred_operations.empty() )
+      return;
+
+   vector< deferred_operation_notification > deferred;
+   std::swap( deferred, _deferred_operations );
+
+   for( auto& d : deferred )
+   {
+      operation_notification note( d.op );
+      note.trx_id       = d.trx_id;
+      note.block        = d.block;
+      note.trx_in_block = d.trx_in_block;
+      note.op_in_trx    = d.op_in_trx;
+      note.virtual_op   = d.virtual_op;
+      note.impacted_accounts       = std::move( d.impacted_accounts );
+      note.impacted_accounts_valid = d.impacted_accounts_valid;
+
+      TRY_NOTIFY( deferred_apply_operation, note )
+      dispatch_operation( _deferred_apply_operation_handlers, note );
+   }
 }
 
 inline const void database::push_virtual_operation( const operation& op, bool force )
@@ -898,6 +1375,9 @@ inline const void database::push_virtual_operation( const operation& op, bool fo
    }
 */
    FC_ASSERT( is_virtual_operation( op ) );
+   if( !has_operation_subscribers( op ) )
+      return;
+
    operation_notification note(op);
    notify_pre_apply_operation( note );
    notify_post_apply_operation( note );
@@ -1335,6 +1815,7 @@ void database::update_owner_authority( const account_object& account, const auth
       auth.last_owner_update = head_block_time();
 
    });
+   _authority_cache.invalidate( account.name );
 }
 
 void database::process_TME_fund_for_SCORE_withdrawals()
@@ -2497,10 +2978,99 @@ void database::notify_changed_objects()
 
 }
 
-void database::set_flush_interval( uint32_t flush_blocks )
+void database::set_flush_interval( uint32_t flush_blocks, uint64_t max_bytes_per_second )
 {
    _flush_blocks = flush_blocks;
-   _next_flush_block = 0;
+   _flush_max_bytes_per_second = max_bytes_per_second;
+}
+
+void database::set_block_signature_threads( uint32_t num_threads )
+{
+   _block_signature_threads.clear();
+   _block_signature_threads.resize( num_threads );
+   for( uint32_t i = 0; i < num_threads; ++i )
+      _block_signature_threads[i] = std::make_shared< fc::thread >( "block_sig_" + std::to_string( i ) );
+}
+
+vector< prepared_transaction > database::prepare_block_transactions( const signed_block& b, bool recover_keys )const
+{
+   const auto& trxs = b.transactions;
+   vector< optional< prepared_transaction > > prepared( trxs.size() );
+   vector< prepared_transaction > result;
+   if( trxs.empty() || _block_signature_threads.empty() )
+      return result;
+
+   size_t num_threads = std::min( _block_signature_threads.size(), trxs.size() );
+   size_t chunk_size = ( trxs.size() + num_threads - 1 ) / num_threads;
+
+   vector< fc::future< void > > done;
+   done.reserve( num_threads );
+   for( size_t t = 0; t < num_threads; ++t )
+   {
+      size_t begin = t * chunk_size;
+      size_t end = std::min( begin + chunk_size, trxs.size() );
+      if( begin >= end )
+         break;
+
+      done.push_back( _block_signature_threads[t]->async( [&trxs, &prepared, recover_keys, begin, end]()
+      {
+         for( size_t i = begin; i < end; ++i )
+         {
+            prepared[i] = prepared_transaction::borrow( trxs[i] );
+            if( !recover_keys )
+               continue;
+
+            try
+            {
+               prepared[i]->signature_keys( CHAIN_ID );
+            }
+            catch( const fc::exception& )
+            {
+               // Not cached, the serial path recovers the keys again and reports the error in block order
+            }
+         }
+      }, "prepare block transactions" ) );
+   }
+
+   for( auto& f : done )
+      f.wait();
+
+   result.reserve( trxs.size() );
+   for( auto& p : prepared )
+      result.push_back( std::move( *p ) );
+
+   return result;
+}
+
+vector< char > database::pack_prepared_block( const signed_block& b )const
+{
+   vector< char > result;
+   auto prepared_itr = _prepared_block_transactions.find( b.id() );
+   if( prepared_itr == _prepared_block_transactions.end() || prepared_itr->second.size() != b.transactions.size() )
+      return result;
+
+   // same bytes as fc::raw::pack( b ): the header, then the transaction vector
+   vector< char > header = fc::raw::pack( static_cast< const signed_block_header& >( b ) );
+   fc::unsigned_int count( b.transactions.size() );
+   size_t size = header.size() + fc::raw::pack_size( count );
+   for( const auto& trx : prepared_itr->second )
+      size += trx.pack_size();
+
+   result.resize( size );
+   fc::datastream< char* > ds( result.data(), result.size() );
+   ds.write( header.data(), header.size() );
+   fc::raw::pack( ds, count );
+   for( const auto& trx : prepared_itr->second )
+      ds.write( trx.packed().data(), trx.pack_size() );
+   return result;
+}
+
+void database::append_to_block_log( const fork_item& item )
+{
+   if( item.packed.empty() )
+      _block_log.append( item.data );
+   else
+      _block_log.append( item.data, item.packed );
 }
 
 //////////////////// private methods ////////////////////
@@ -2510,6 +3080,7 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
    //fc::time_point begin_time = fc::time_point::now();
 
    auto block_num = next_block.block_num();
+   TRACE_SPAN( "apply_block", block_num );
    if( _checkpoints.size() && _checkpoints.rbegin()->second != block_id_type() )
    {
       auto itr = _checkpoints.find( block_num );
@@ -2534,6 +3105,7 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
    detail::with_skip_flags( *this, skip, [&]()
    {
+      authority_cache::scoped_enable authority_cache_scope( _authority_cache );
       _apply_block( next_block );
    } );
 
@@ -2547,33 +3119,6 @@ void database::apply_block( const signed_block& next_block, uint32_t skip )
 
    //fc::time_point end_time = fc::time_point::now();
    //fc::microseconds dt = end_time - begin_time;
-   if( _flush_blocks != 0 )
-   {
-      if( _next_flush_block == 0 )
-      {
-         uint32_t lep = block_num + 1 + _flush_blocks * 9 / 10;
-         uint32_t rep = block_num + 1 + _flush_blocks;
-
-         // use time_point::now() as RNG source to pick block randomly between lep and rep
-         uint32_t span = rep - lep;
-         uint32_t x = lep;
-         if( span > 0 )
-         {
-            uint64_t now = uint64_t( fc::time_point::now().time_since_epoch().count() );
-            x += now % span;
-         }
-         _next_flush_block = x;
-         //ilog( "Next flush scheduled at block ${b}", ("b", x) );
-      }
-
-      if( _next_flush_block == block_num )
-      {
-         _next_flush_block = 0;
-         //ilog( "Flushing database shared memory at block ${b}", ("b", block_num) );
-         chainbase::database::flush();
-      }
-   }
-
    show_free_memory( false );
 
 } FC_CAPTURE_AND_RETHROW( (next_block) ) }
@@ -2598,6 +3143,7 @@ void database::show_free_memory( bool force )
 
 void database::_apply_block( const signed_block& next_block )
 { try {
+   _deferred_operations.clear();
    notify_pre_apply_block( next_block );
 
    uint32_t next_block_num = next_block.block_num();
@@ -2605,9 +3151,32 @@ void database::_apply_block( const signed_block& next_block )
 
    uint32_t skip = get_node_properties().skip_flags;
 
+   // Every transaction is packed and hashed once here (or ahead of time by push_block) and the result is
+   // shared by the merkle check, the duplicate check and the authority check.
+   vector< prepared_transaction > local_prepared;
+   const vector< prepared_transaction >* prepared = nullptr;
+   if( _prepared_block_transactions.size() )
+   {
+      auto prepared_itr = _prepared_block_transactions.find( next_block.id() );
+      if( prepared_itr != _prepared_block_transactions.end() && prepared_itr->second.size() == next_block.transactions.size() )
+         prepared = &prepared_itr->second;
+   }
+   if( prepared == nullptr )
+   {
+      local_prepared.reserve( next_block.transactions.size() );
+      for( const auto& trx : next_block.transactions )
+         local_prepared.push_back( prepared_transaction::borrow( trx ) );
+      prepared = &local_prepared;
+   }
+
    if( !( skip & skip_merkle_check ) )
    {
-      auto merkle_root = next_block.calculate_merkle_root();
+      TRACE_SPAN( "_apply_block merkle check" );
+      vector< digest_type > merkle_digests;
+      merkle_digests.reserve( prepared->size() );
+      for( const auto& ptrx : *prepared )
+         merkle_digests.push_back( ptrx.merkle_digest() );
+      auto merkle_root = signed_block::calculate_merkle_root( std::move( merkle_digests ) );
 
       try
       {
@@ -2661,46 +3230,57 @@ void database::_apply_block( const signed_block& next_block )
       );
    }
 
-   for( const auto& trx : next_block.transactions )
    {
-      /* We do not need to push the undo state for each transaction
-       * because they either all apply and are valid or the
-       * entire block fails to apply.  We only need an "undo" state
-       * for transactions when validating broadcast transactions or
-       * when building a block.
-       */
-      apply_transaction( trx, skip );
-      ++_current_trx_in_block;
+      TRACE_SPAN( "_apply_block transactions", int64_t( prepared->size() ) );
+      for( const auto& ptrx : *prepared )
+      {
+         /* We do not need to push the undo state for each transaction
+          * because they either all apply and are valid or the
+          * entire block fails to apply.  We only need an "undo" state
+          * for transactions when validating broadcast transactions or
+          * when building a block.
+          */
+         apply_transaction( ptrx, skip );
+         ++_current_trx_in_block;
+      }
    }
 
-   update_global_dynamic_data(next_block);
-   update_signing_witness(signing_witness, next_block);
-
-   update_last_irreversible_block();
+   // Deliver transaction operations before the head block time moves forward
+   notify_deferred_apply_operations();
 
-   create_block_summary(next_block);
-   clear_expired_transactions();
-   clear_expired_orders();
-   clear_expired_delegations();
-   update_witness_schedule(*this);
-
-   update_median_feed();
-   update_virtual_supply();
-
-   clear_null_account_balance();
-   process_funds();
-   process_conversions();
-   process_comment_cashout();
-   process_TME_fund_for_SCORE_withdrawals();
-   process_savings_withdraws();
-   pay_liquidity_reward();
-   update_virtual_supply();
-
-   account_recovery_processing();
-   expire_escrow_ratification();
-   process_decline_voting_rights();
+   {
+      TRACE_SPAN( "_apply_block maintenance" );
+      update_global_dynamic_data(next_block);
+      update_signing_witness(signing_witness, next_block);
+
+      update_last_irreversible_block();
+
+      create_block_summary(next_block);
+      clear_expired_transactions();
+      clear_expired_orders();
+      clear_expired_delegations();
+      update_witness_schedule(*this);
+
+      update_median_feed();
+      update_virtual_supply();
+
+      clear_null_account_balance();
+      process_funds();
+      process_conversions();
+      process_comment_cashout();
+      process_TME_fund_for_SCORE_withdrawals();
+      process_savings_withdraws();
+      pay_liquidity_reward();
+      update_virtual_supply();
+
+      account_recovery_processing();
+      expire_escrow_ratification();
+      process_decline_voting_rights();
+
+      process_hardforks();
+   }
 
-   process_hardforks();
+   notify_deferred_apply_operations();
 
    // notify observers that the block has been applied
    notify_applied_block( next_block );
@@ -2829,15 +3409,22 @@ try {
    }
 } FC_CAPTURE_AND_RETHROW() }
 
-void database::apply_transaction(const signed_transaction& trx, uint32_t skip)
+void database::apply_transaction(const prepared_transaction& trx, uint32_t skip)
 {
+   TRACE_SPAN( "apply_transaction" );
    detail::with_skip_flags( *this, skip, [&]() { _apply_transaction(trx); });
-   notify_on_applied_transaction( trx );
+   notify_on_applied_transaction( *trx );
 }
 
 void database::_apply_transaction(const signed_transaction& trx)
+{
+   _apply_transaction( prepared_transaction::borrow( trx ) );
+}
+
+void database::_apply_transaction(const prepared_transaction& ptrx)
 { try {
-   _current_trx_id = trx.id();
+   const signed_transaction& trx = *ptrx;
+   _current_trx_id = ptrx.id();
    uint32_t skip = get_node_properties().skip_flags;
 
    if( !(skip&skip_validate) )   /* issue #505 explains why this skip_flag is disabled */
@@ -2845,7 +3432,7 @@ void database::_apply_transaction(const signed_transaction& trx)
 
    auto& trx_idx = get_index<transaction_index>();
    const chain_id_type& chain_id = CHAIN_ID;
-   auto trx_id = trx.id();
+   const auto& trx_id = ptrx.id();
    // idump((trx_id)(skip&skip_transaction_dupe_check));
    FC_ASSERT( (skip & skip_transaction_dupe_check) ||
               trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
@@ -2853,13 +3440,15 @@ void database::_apply_transaction(const signed_transaction& trx)
 
    if( !(skip & (skip_transaction_signatures | skip_authority_check) ) )
    {
-      auto get_active  = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).active ); };
-      auto get_owner   = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).owner );  };
-      auto get_posting = [&]( const string& name ) { return authority( get< account_authority_object, by_account >( name ).posting );  };
+      // Within a block the decoded authorities are shared by all of its transactions, a transaction pushed
+      // on its own gets a cache of its own since its changes may be undone
+      authority_cache trx_authority_cache( *this );
+      authority_cache& auth_cache = _authority_cache.enabled() ? _authority_cache : trx_authority_cache;
 
       try
       {
-         trx.verify_authority( chain_id, get_active, get_owner, get_posting, MAX_SIG_CHECK_DEPTH );
+         protocol::verify_authority( trx.operations, ptrx.signature_keys( chain_id ),
+            auth_cache.active_getter(), auth_cache.owner_getter(), auth_cache.posting_getter(), MAX_SIG_CHECK_DEPTH );
       }
       catch( protocol::tx_missing_active_auth& e )
       {
@@ -2896,8 +3485,10 @@ void database::_apply_transaction(const signed_transaction& trx)
       create<transaction_object>([&](transaction_object& transaction) {
          transaction.trx_id = trx_id;
          transaction.expiration = trx.expiration;
-         fc::raw::pack( transaction.packed_trx, trx );
+         transaction.block_num = head_block_num() + 1;
+         transaction.trx_in_block = _current_trx_in_block;
       });
+      _known_transaction_filter.insert( trx_id, head_block_time().sec_since_epoch() );
    }
 
    notify_on_pre_apply_transaction( trx );
@@ -2912,10 +3503,16 @@ void database::_apply_transaction(const signed_transaction& trx)
    }
    _current_trx_id = transaction_id_type();
 
-} FC_CAPTURE_AND_RETHROW( (trx) ) }
+} FC_CAPTURE_AND_RETHROW( (ptrx.get()) ) }
 
 void database::apply_operation(const operation& op)
 {
+   if( !has_operation_subscribers( op ) )
+   {
+      _my->_evaluator_registry.get_evaluator( op ).apply( op );
+      return;
+   }
+
    operation_notification note(op);
    notify_pre_apply_operation( note );
    _my->_evaluator_registry.get_evaluator( op ).apply( op );
@@ -2924,6 +3521,7 @@ void database::apply_operation(const operation& op)
 
 const witness_object& database::validate_block_header( uint32_t skip, const signed_block& next_block )const
 { try {
+   TRACE_SPAN( "_apply_block validate header" );
    FC_ASSERT( head_block_id() == next_block.previous, "", ("head_block_id",head_block_id())("next.prev",next_block.previous) );
    FC_ASSERT( head_block_time() < next_block.timestamp, "", ("head_block_time",head_block_time())("next",next_block.timestamp)("blocknum",next_block.block_num()) );
    const witness_object& witness = get_witness( next_block.witness );
@@ -2945,6 +3543,16 @@ const witness_object& database::validate_block_header( uint32_t skip, const sign
    return witness;
 } FC_CAPTURE_AND_RETHROW() }
 
+void database::precheck_block( const signed_block& next_block )const
+{ try {
+   validate_block_header( skip_nothing, next_block );
+
+   if( has_hardfork( HARDFORK_0_12 ) )
+      FC_ASSERT( fc::raw::pack_size( next_block ) <= get_dynamic_global_properties().maximum_block_size, "Block Size is too Big" );
+
+   FC_ASSERT( next_block.transaction_merkle_root == next_block.calculate_merkle_root(), "Merkle check failed" );
+} FC_CAPTURE_AND_RETHROW( (next_block.block_num()) ) }
+
 void database::create_block_summary(const signed_block& next_block)
 { try {
    block_summary_id_type sid( next_block.block_num() & 0xffff );
@@ -3115,7 +3723,7 @@ void database::update_last_irreversible_block()
          {
             shared_ptr< fork_item > block = _fork_db.fetch_block_on_main_branch_by_number( log_head_num+1 );
             FC_ASSERT( block, "Current fork in the fork database does not contain the last_irreversible_block" );
-            _block_log.append( block->data );
+            append_to_block_log( *block );
             log_head_num++;
          }
 
@@ -3631,10 +4239,15 @@ void database::set_hardfork( uint32_t hardfork, bool apply_now )
       if( apply_now )
          apply_hardfork( i );
    }
+
+   notify_deferred_apply_operations();
 }
 
 void database::apply_hardfork( uint32_t hardfork )
 {
+   // Some hardforks rewrite account authorities directly
+   _authority_cache.clear();
+
    if( _log_hardforks )
       elog( "HARDFORK ${hf} at block ${b}", ("hf", hardfork)("b", head_block_num()) );
 
@@ -2,6 +2,10 @@
 
 #include <node/chain/database_exceptions.hpp>
 
+#include <fc/io/raw.hpp>
+
+#include <fstream>
+
 namespace node { namespace chain {
 
 fork_database::fork_database()
@@ -32,9 +36,9 @@ void     fork_database::start_block(signed_block b)
  * Pushes the block into the fork database and caches it if it doesn't link
  *
  */
-shared_ptr<fork_item>  fork_database::push_block(const signed_block& b)
+shared_ptr<fork_item>  fork_database::push_block(const signed_block& b, vector< char > packed)
 {
-   auto item = std::make_shared<fork_item>(b);
+   auto item = std::make_shared<fork_item>(b, std::move(packed));
    try {
       _push_block(item);
    }
@@ -235,6 +239,47 @@ void fork_database::set_head(shared_ptr<fork_item> h)
    _head = h;
 }
 
+void fork_database::save( const fc::path& file, uint32_t min_block_num )const
+{ try {
+   vector< item_ptr > items;
+   for( const auto& index : { &_index, &_unlinked_index } )
+   {
+      const auto& by_num_idx = index->get<block_num>();
+      for( auto itr = by_num_idx.upper_bound( min_block_num ); itr != by_num_idx.end(); ++itr )
+         if( !(*itr)->invalid )
+            items.push_back( *itr );
+   }
+   std::stable_sort( items.begin(), items.end(), []( const item_ptr& a, const item_ptr& b ) { return a->num < b->num; } );
+
+   vector< signed_block > blocks;
+   blocks.reserve( items.size() );
+   for( const auto& item : items )
+      blocks.push_back( item->data );
+
+   fc::path tmp_file = file.generic_string() + ".tmp";
+   {
+      auto data = fc::raw::pack( blocks );
+      std::ofstream out( tmp_file.generic_string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+      out.write( data.data(), data.size() );
+      out.flush();
+      FC_ASSERT( out.good(), "Error writing fork database file" );
+   }
+   fc::rename( tmp_file, file );
+} FC_CAPTURE_AND_RETHROW( (file)(min_block_num) ) }
+
+vector< signed_block > fork_database::load( const fc::path& file )
+{ try {
+   vector< signed_block > blocks;
+
+   std::ifstream in( file.generic_string().c_str(), std::ios::in | std::ios::binary );
+   FC_ASSERT( in.good(), "Unable to open fork database file" );
+   vector< char > data( ( std::istreambuf_iterator< char >( in ) ), std::istreambuf_iterator< char >() );
+
+   if( data.size() )
+      fc::raw::unpack( data, blocks );
+   return blocks;
+} FC_CAPTURE_AND_RETHROW( (file) ) }
+
 void fork_database::remove(block_id_type id)
 {
    _index.get<block_id>().erase(id);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <node/protocol/sign_state.hpp>
+
+#include <node/chain/node_object_types.hpp>
+
+#include <fc/optional.hpp>
+
+#include <map>
+
+namespace node { namespace chain {
+
+   class database;
+   class account_authority_object;
+   struct shared_authority;
+
+   using node::protocol::authority;
+   using node::protocol::authority_getter;
+
+   /**
+    *  Account authorities decoded from their shared_authority, so repeated and recursive lookups
+    *  during signature checks do not convert (and allocate) the same authority again. Each level
+    *  is decoded on first use and handed out by reference until the account is invalidated.
+    *
+    *  Entries are not tied to chain state: whoever modifies an account_authority_object, or undoes
+    *  such a modification, has to invalidate or clear the cache.
+    */
+   class authority_cache
+   {
+      public:
+         authority_cache( const database& db ) : _db( db ) {}
+
+         const authority& get_active( const account_name_type& account );
+         const authority& get_owner( const account_name_type& account );
+         const authority& get_posting( const account_name_type& account );
+
+         /// Getters for verify_authority() and get_required_signatures(), valid as long as the cache
+         authority_getter active_getter()  { return [this]( const string& account ) -> const authority& { return get_active( account ); }; }
+         authority_getter owner_getter()   { return [this]( const string& account ) -> const authority& { return get_owner( account ); }; }
+         authority_getter posting_getter() { return [this]( const string& account ) -> const authority& { return get_posting( account ); }; }
+
+         void invalidate( const account_name_type& account ) { _entries.erase( account ); }
+         void clear() { _entries.clear(); }
+
+         bool enabled()const { return _enabled; }
+
+         /// Enables the cache for the lifetime of the scope, it starts and ends empty
+         struct scoped_enable
+         {
+            scoped_enable( authority_cache& c ) : cache( c ) { cache.clear(); cache._enabled = true; }
+            ~scoped_enable() { cache._enabled = false; cache.clear(); }
+
+            authority_cache& cache;
+         };
+
+      private:
+         struct entry
+         {
+            fc::optional< authority > active;
+            fc::optional< authority > owner;
+            fc::optional< authority > posting;
+         };
+
+         const authority& get( const account_name_type& account,
+            fc::optional< authority > entry::* level, const shared_authority account_authority_object::* stored );
+
+         const database&                        _db;
+         std::map< account_name_type, entry >   _entries;
+         bool                                   _enabled = false;
+   };
+
+} } // node::chain
@@ -43,10 +43,21 @@ namespace node { namespace chain {
          bool is_open()const;
 
          uint64_t append( const signed_block& b );
+
+         /**
+          * Appends b using its already packed form, packed must be fc::raw::pack( b ).
+          */
+         uint64_t append( const signed_block& b, const vector< char >& packed );
          void flush();
          std::pair< signed_block, uint64_t > read_block( uint64_t file_pos )const;
          optional< signed_block > read_block_by_num( uint32_t block_num )const;
 
+         /**
+          * Return the packed block as stored in the log, without decoding it. Empty if the block
+          * is not in the log.
+          */
+         vector< char > read_block_bytes_by_num( uint32_t block_num )const;
+
          /**
           * Return offset of block in file, or block_log::npos if it does not exist.
           */
@@ -7,12 +7,18 @@
 #include <node/chain/node_property_object.hpp>
 #include <node/chain/fork_database.hpp>
 #include <node/chain/block_log.hpp>
+#include <node/chain/shared_memory_flusher.hpp>
+#include <node/chain/authority_cache.hpp>
+#include <node/chain/known_id_filter.hpp>
 #include <node/chain/operation_notification.hpp>
 
 #include <node/protocol/protocol.hpp>
+#include <node/protocol/prepared_transaction.hpp>
+#include <node/protocol/block_view.hpp>
 
 //#include <graphene/db2/database.hpp>
 #include <fc/signals.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <fc/log/logger.hpp>
 
@@ -26,6 +32,8 @@ namespace node { namespace chain {
    using node::protocol::asset;
    using node::protocol::asset_symbol_type;
    using node::protocol::price;
+   using node::protocol::public_key_type;
+   using node::protocol::prepared_transaction;
 
    class database_impl;
    class custom_operation_interpreter;
@@ -65,7 +73,7 @@ namespace node { namespace chain {
             skip_witness_schedule_check = 1 << 9,  ///< used while reindexing
             skip_validate               = 1 << 10, ///< used prior to checkpoint, skips validate() call on transaction
             skip_validate_invariants    = 1 << 11, ///< used to skip database invariant check on block application
-            skip_undo_block             = 1 << 12, ///< used to skip undo db on reindex
+            skip_undo_block             = 1 << 12, ///< used to apply sync blocks as irreversible, without undo history or fork db
             skip_block_log              = 1 << 13  ///< used to skip block logging on reindex
          };
 
@@ -104,12 +112,27 @@ namespace node { namespace chain {
           */
          bool                       is_known_block( const block_id_type& id )const;
          bool                       is_known_transaction( const transaction_id_type& id )const;
+
+         /**
+          *  Lock-free pre-checks for is_known_block() and is_known_transaction(), which may be called
+          *  from any thread without holding a lock. false means the id is certainly unknown, true that
+          *  it might be known and the exact check has to be made.
+          */
+         bool                       might_know_block( const block_id_type& id )const;
+         bool                       might_know_transaction( const transaction_id_type& id )const;
          fc::sha256                 get_pow_target()const;
          uint32_t                   get_pow_summary_target()const;
          block_id_type              find_block_id_for_num( uint32_t block_num )const;
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+
+         /**
+          *  Packed form of a block. Irreversible blocks are read from the block log as stored,
+          *  without being decoded, reversible blocks are packed from the fork database.
+          */
+         optional< vector< char > > fetch_block_bytes_by_id( const block_id_type& id )const;
+         optional< vector< char > > fetch_block_bytes_by_number( uint32_t num )const;
          const signed_transaction   get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -164,10 +187,42 @@ namespace node { namespace chain {
          bool                                   before_last_checkpoint()const;
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+
+         /**
+          *  The checks of a block that don't need it applied: it builds on the head block, was signed by the
+          *  witness scheduled for its slot, fits the block size limit and its transactions hash to its merkle
+          *  root. Throws if any of them fails.
+          */
+         void precheck_block( const signed_block& b )const;
+
+         /**
+          *  Pushes a run of blocks, oldest first, with a single acquisition of the write lock and with
+          *  the pending transactions set aside once for the whole run.
+          *
+          *  A failing block does not abort the run, on return results[i] holds the exception thrown by
+          *  blocks[i] or is null if the block was accepted.
+          */
+         void push_blocks( const vector< signed_block >& blocks,
+                           vector< fc::exception_ptr >& results,
+                           uint32_t skip = skip_nothing );
          void push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
+
+         /**
+          *  Pushes a batch of transactions into the pending queue under a single acquisition of the
+          *  write lock. Signing keys already recovered on the prepared transactions are not
+          *  recovered again while holding the lock.
+          *
+          *  A failing transaction does not abort the batch, on return results[i] holds the exception
+          *  thrown by trxs[i] or is null if the transaction was accepted.
+          */
+         void push_transactions( const vector< prepared_transaction >& trxs,
+                                 vector< fc::exception_ptr >& results,
+                                 uint32_t skip = skip_nothing );
          void _maybe_warn_multiple_production( uint32_t height )const;
          bool _push_block( const signed_block& b );
+         void _push_irreversible_block( const signed_block& b );
          void _push_transaction( const signed_transaction& trx );
+         void _push_transaction( const prepared_transaction& trx );
 
          signed_block generate_block(
             const fc::time_point_sec when,
@@ -192,6 +247,7 @@ namespace node { namespace chain {
           */
          void notify_pre_apply_operation( operation_notification& note );
          void notify_post_apply_operation( const operation_notification& note );
+         void notify_deferred_apply_operations();
          inline const void push_virtual_operation( const operation& op, bool force = false ); // vops are not needed for low mem. Force will push them on low mem.
          void notify_pre_apply_block( const signed_block& block );
          void notify_applied_block( const signed_block& block );
@@ -205,6 +261,31 @@ namespace node { namespace chain {
          fc::signal<void(const operation_notification&)> pre_apply_operation;
          fc::signal<void(const operation_notification&)> post_apply_operation;
 
+         /**
+          *  Delivers every operation in the order of pre_apply_operation, but only once the
+          *  transaction (or the transactions of a block) has been evaluated. Slots are invoked in a
+          *  batch under the same undo session as the operations, so anything they create is rolled
+          *  back together with the block or transaction.
+          *
+          *  Plugins which only need the operation contents and head_block_time() should use this
+          *  instead of pre/post_apply_operation to stay out of the evaluator loop.
+          */
+         fc::signal<void(const operation_notification&)> deferred_apply_operation;
+
+         typedef std::function< void( const operation_notification& ) > operation_handler;
+
+         /**
+          *  Registers handler for the operation types in op_tags only, it is called right after the
+          *  slots of the matching signal. Operations nobody subscribed to (by signal or by type) skip
+          *  building the notification entirely. Build op_tags with operation_tags< Ops... >().
+          */
+         void subscribe_pre_apply_operation( const vector< int64_t >& op_tags, const operation_handler& handler );
+         void subscribe_post_apply_operation( const vector< int64_t >& op_tags, const operation_handler& handler );
+         void subscribe_deferred_apply_operation( const vector< int64_t >& op_tags, const operation_handler& handler );
+
+         template< typename... Ops >
+         static vector< int64_t > operation_tags() { return { operation::tag< Ops >::value... }; }
+
          fc::signal<void(const signed_block&)>           pre_apply_block;
 
          /**
@@ -296,6 +377,8 @@ namespace node { namespace chain {
          void        adjust_supply( const asset& delta, bool adjust_TME_fund_for_SCORE = false );
          void        adjust_SCOREreward2( const comment_object& comment, fc::uint128_t old_SCOREreward2, fc::uint128_t new_SCOREreward2 );
          void        update_owner_authority( const account_object& account, const authority& owner_authority );
+         /// Must follow any other modification of an account's authorities
+         void        invalidate_cached_authority( const account_name_type& account ) { _authority_cache.invalidate( account ); }
 
          asset       get_balance( const account_object& a, asset_symbol_type symbol )const;
          asset       get_TMEsavingsBalance( const account_object& a, asset_symbol_type symbol )const;
@@ -405,7 +488,20 @@ namespace node { namespace chain {
 
          const std::string& get_json_schema() const;
 
-         void set_flush_interval( uint32_t flush_blocks );
+         /**
+          *  The shared memory file is written back to disk in the background, one pass over the
+          *  whole file every flush_blocks blocks' worth of time, at most max_bytes_per_second
+          *  (0 for no cap). flush_blocks == 0 leaves write back to the OS.
+          */
+         void set_flush_interval( uint32_t flush_blocks, uint64_t max_bytes_per_second = 0 );
+         shared_memory_flush_stats get_shared_memory_flush_stats()const { return _state_flusher.get_stats(); }
+
+         /**
+          *  Starts num_threads threads used to prepare the transactions of an incoming block (pack,
+          *  hash and recover the signing keys) before the write lock is taken. 0 (the default)
+          *  prepares them serially while the block is applied.
+          */
+         void set_block_signature_threads( uint32_t num_threads );
          void show_free_memory( bool force );
 
 #ifdef IS_TEST_NET
@@ -423,11 +519,18 @@ namespace node { namespace chain {
          optional< chainbase::database::session > _pending_tx_session;
 
          void apply_block( const signed_block& next_block, uint32_t skip = skip_nothing );
-         void apply_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
+         void apply_transaction( const prepared_transaction& trx, uint32_t skip = skip_nothing );
          void _apply_block( const signed_block& next_block );
          void _apply_transaction( const signed_transaction& trx );
+         void _apply_transaction( const prepared_transaction& trx );
          void apply_operation( const operation& op );
 
+         /// Prepares every transaction of b on _block_signature_threads, the results borrow the transactions of b
+         vector< prepared_transaction > prepare_block_transactions( const signed_block& b, bool recover_keys )const;
+         /// b packed from the bytes of its prepared transactions, empty if b wasn't prepared
+         vector< char > pack_prepared_block( const signed_block& b )const;
+         void append_to_block_log( const fork_item& item );
+
 
          ///Steps involved in applying a new block
          ///@{
@@ -460,6 +563,12 @@ namespace node { namespace chain {
 
          block_log                     _block_log;
 
+         /// Reversible blocks are saved here on close() and reapplied by open()
+         fc::path                      _fork_db_file;
+         void                          reapply_saved_fork_blocks();
+
+         void                          reset_known_id_filters();
+
          // this function needs access to _plugin_index_signal
          template< typename MultiIndexType >
          friend void add_plugin_index( database& db );
@@ -477,10 +586,35 @@ namespace node { namespace chain {
          node_property_object              _node_property_object;
 
          uint32_t                      _flush_blocks = 0;
-         uint32_t                      _next_flush_block = 0;
+         uint64_t                      _flush_max_bytes_per_second = 0;
+         shared_memory_flusher         _state_flusher;
+
+         /// Decoded authorities shared by the transactions of the block being applied
+         authority_cache               _authority_cache;
+
+         /// Blocks pushed (by block number) and transactions added to the dupe check index (by head block time)
+         known_id_filter               _known_block_filter;
+         known_id_filter               _known_transaction_filter;
 
          uint32_t                      _last_free_gb_printed = 0;
 
+         vector< deferred_operation_notification > _deferred_operations;
+
+         /// Handlers subscribed by operation type, indexed by operation::which()
+         typedef vector< vector< operation_handler > > operation_dispatch_table;
+
+         operation_dispatch_table      _pre_apply_operation_handlers;
+         operation_dispatch_table      _post_apply_operation_handlers;
+         operation_dispatch_table      _deferred_apply_operation_handlers;
+
+         void subscribe_operation_handler( operation_dispatch_table& table, const vector< int64_t >& op_tags, const operation_handler& handler );
+         void dispatch_operation( const operation_dispatch_table& table, const operation_notification& note );
+         bool has_operation_subscribers( const operation& op )const;
+         bool has_deferred_operation_subscribers( const operation& op )const;
+
+         std::vector< std::shared_ptr< fc::thread > >                                 _block_signature_threads;
+         flat_map< block_id_type, vector< prepared_transaction > >                    _prepared_block_transactions;
+
          flat_map< std::string, std::shared_ptr< custom_operation_interpreter > >   _custom_operation_interpreters;
          std::string                       _json_schema;
    };
@@ -2,6 +2,8 @@
 
 #include <node/protocol/exceptions.hpp>
 
+#include <graphene/utilities/trace.hpp>
+
 #define DECLARE_OP_BASE_EXCEPTIONS( op_name )                \
    FC_DECLARE_DERIVED_EXCEPTION(                                      \
       op_name ## _validate_exception,                                 \
@@ -45,6 +47,7 @@
 #define TRY_NOTIFY( signal, ... )                                     \
    try                                                                        \
    {                                                                          \
+      TRACE_SPAN( "notify " #signal );                                        \
       signal( __VA_ARGS__ );                                                  \
    }                                                                          \
    catch( const node::chain::plugin_exception& e )                         \
@@ -1,6 +1,8 @@
 #pragma once
 #include <node/protocol/block.hpp>
 
+#include <fc/filesystem.hpp>
+
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/ordered_index.hpp>
@@ -17,8 +19,8 @@ namespace node { namespace chain {
 
    struct fork_item
    {
-      fork_item( signed_block d )
-      :num(d.block_num()),id(d.id()),data( std::move(d) ){}
+      fork_item( signed_block d, vector< char > p = vector< char >() )
+      :num(d.block_num()),id(d.id()),data( std::move(d) ),packed( std::move(p) ){}
 
       block_id_type previous_id()const { return data.previous; }
 
@@ -31,6 +33,7 @@ namespace node { namespace chain {
       bool                  invalid = false;
       block_id_type         id;
       signed_block          data;
+      vector< char >        packed; ///< data as packed bytes if they were known when it was pushed, empty otherwise
    };
    typedef shared_ptr<fork_item> item_ptr;
 
@@ -65,7 +68,7 @@ namespace node { namespace chain {
          /**
           *  @return the new head block ( the longest fork )
           */
-         shared_ptr<fork_item>            push_block(const signed_block& b);
+         shared_ptr<fork_item>            push_block(const signed_block& b, vector< char > packed = vector< char >());
          shared_ptr<fork_item>            head()const { return _head; }
          void                             pop_block();
 
@@ -92,6 +95,15 @@ namespace node { namespace chain {
 
          void set_max_size( uint32_t s );
 
+         /**
+          *  Writes every block above min_block_num, linked or not, to file in block number order.
+          *  The file is replaced by rename, so an interrupted save leaves the previous one intact.
+          */
+         void                             save( const fc::path& file, uint32_t min_block_num )const;
+
+         /// Reads back the blocks written by save(), in the order they were written
+         static vector< signed_block >    load( const fc::path& file );
+
       private:
          /** @return a pointer to the newly pushed item */
          void _push_block(const item_ptr& b );
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <fc/crypto/ripemd160.hpp>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+
+namespace node { namespace chain {
+
+   /**
+    *  Rolling bloom filter over block or transaction ids. One thread inserts (the one applying blocks),
+    *  any number of threads query it without taking a lock.
+    *
+    *  Every insert carries a mark, a position which only grows such as a block number or a block time.
+    *  The filter keeps two generations of bits and clears the older one once the newer one is full, so
+    *  it only answers for the ids inserted since covered_from(). Within that range it has false
+    *  positives, like any bloom filter, but no false negatives.
+    */
+   class known_id_filter
+   {
+      public:
+         /// @param capacity ids per generation, each gets 16 bits of filter for about 0.25% false positives
+         explicit known_id_filter( uint32_t capacity );
+
+         /// Forgets all ids, the ones inserted from now on are covered starting at mark
+         void reset( uint64_t mark );
+         void insert( const fc::ripemd160& id, uint64_t mark );
+
+         /**
+          *  True if id is certainly not among the ids inserted with a mark of at least since. False if
+          *  it might be, if the filter doesn't reach back to since or if a generation was cleared while
+          *  checking.
+          */
+         bool excludes( const fc::ripemd160& id, uint64_t since )const;
+
+         uint64_t covered_from()const { return _covered_from.load( std::memory_order_relaxed ); }
+         /// The highest mark inserted so far, 0 if there was none
+         uint64_t last_mark()const { return _last_mark.load( std::memory_order_relaxed ); }
+
+      private:
+         struct generation
+         {
+            std::unique_ptr< std::atomic< uint64_t >[] > words;
+            uint32_t                                     count = 0;
+            uint64_t                                     first_mark = 0;
+         };
+
+         bool might_contain( const generation& g, uint64_t h1, uint64_t h2 )const;
+         void clear( generation& g );
+
+         uint32_t                   _capacity;
+         uint64_t                   _word_mask;
+         generation                 _generations[2];
+         uint32_t                   _current = 0;
+
+         /// odd while a generation is being cleared
+         std::atomic< uint64_t >    _rotations{ 0 };
+         std::atomic< uint64_t >    _covered_from{ std::numeric_limits< uint64_t >::max() };
+         std::atomic< uint64_t >    _last_mark{ 0 };
+   };
+
+} } // node::chain
@@ -4,8 +4,13 @@
 
 #include <node/chain/node_object_types.hpp>
 
+#include <boost/container/small_vector.hpp>
+
 namespace node { namespace chain {
 
+/// Sorted, unique set of accounts impacted by an operation, almost always small enough for the inline buffer
+typedef boost::container::small_vector< account_name_type, 4 > impacted_accounts_type;
+
 struct operation_notification
 {
    operation_notification( const operation& o ) : op(o) {}
@@ -16,6 +21,37 @@ struct operation_notification
    uint16_t            op_in_trx = 0;
    uint64_t            virtual_op = 0;
    const operation&    op;
+
+   /// Filled on first use by app::operation_get_impacted_accounts( note ) and shared by every later caller,
+   /// including the deferred_apply_operation handlers
+   mutable impacted_accounts_type   impacted_accounts;
+   mutable bool                     impacted_accounts_valid = false;
+
+   /// Position of the deferred copy of this notification in the database, -1 if it isn't deferred
+   int64_t                          deferred_index = -1;
+};
+
+/**
+ *  Owning copy of an operation_notification, held by the database until the
+ *  operation is delivered through database::deferred_apply_operation.
+ */
+struct deferred_operation_notification
+{
+   deferred_operation_notification( const operation_notification& note )
+      : trx_id( note.trx_id ), block( note.block ), trx_in_block( note.trx_in_block ),
+        op_in_trx( note.op_in_trx ), virtual_op( note.virtual_op ), op( note.op ),
+        impacted_accounts( note.impacted_accounts ), impacted_accounts_valid( note.impacted_accounts_valid ) {}
+
+   transaction_id_type trx_id;
+   uint32_t            block = 0;
+   uint32_t            trx_in_block = 0;
+   uint16_t            op_in_trx = 0;
+   uint64_t            virtual_op = 0;
+   operation           op;
+
+   /// Impacted accounts computed while the operation was applied, handed on to the deferred notification
+   impacted_accounts_type   impacted_accounts;
+   bool                     impacted_accounts_valid = false;
 };
 
 } }
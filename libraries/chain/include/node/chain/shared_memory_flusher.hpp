@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chainbase/chainbase.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/thread/mutex.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/time.hpp>
+
+#include <atomic>
+
+namespace node { namespace chain {
+
+   struct shared_memory_flush_stats
+   {
+      uint64_t          segment_size = 0;
+      uint64_t          dirty_bytes = 0;          ///< sampled at the end of the last complete pass
+      uint64_t          passes = 0;               ///< complete passes over the file
+      fc::microseconds  last_chunk_duration;
+      fc::microseconds  max_chunk_duration;
+      fc::microseconds  last_pass_duration;       ///< wall clock time of the last complete pass, pauses included
+      fc::microseconds  last_pass_flush_time;     ///< time spent writing during the last complete pass
+      fc::time_point    last_pass_end;
+   };
+
+   /**
+    *  Writes the shared memory file back to disk from a background thread, one chunk at a time,
+    *  so block processing never waits on an msync of the whole mapping.
+    *
+    *  A pass over the file is spread evenly over pass_interval and the write rate is capped at
+    *  max_bytes_per_second (0 for no cap). Only the dirty pages of a chunk cause any I/O.
+    */
+   class shared_memory_flusher
+   {
+      public:
+         static const uint64_t chunk_size = 8 * 1024 * 1024;
+
+         shared_memory_flusher( chainbase::database& db ) : _db( db ), _stopping( false ) {}
+         ~shared_memory_flusher();
+
+         void start( fc::microseconds pass_interval, uint64_t max_bytes_per_second );
+         void stop();
+
+         shared_memory_flush_stats get_stats()const;
+
+      private:
+         void run();
+         void pause( int64_t microseconds );
+
+         chainbase::database&             _db;
+         fc::microseconds                 _pass_interval;
+         uint64_t                         _max_bytes_per_second = 0;
+
+         std::shared_ptr< fc::thread >    _thread;
+         fc::future< void >               _done;
+         std::atomic< bool >              _stopping;
+
+         mutable fc::mutex                _stats_mutex;
+         shared_memory_flush_stats        _stats;
+   };
+
+} } // node::chain
+
+FC_REFLECT( node::chain::shared_memory_flush_stats,
+            (segment_size)(dirty_bytes)(passes)(last_chunk_duration)(max_chunk_duration)
+            (last_pass_duration)(last_pass_flush_time)(last_pass_end) )
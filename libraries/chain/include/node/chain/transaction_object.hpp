@@ -13,6 +13,8 @@ namespace node { namespace chain {
     * The purpose of this object is to enable the detection of duplicate transactions. When a transaction is included
     * in a block a transaction_object is added. At the end of block processing all transaction_objects that have
     * expired can be removed from the index.
+    *
+    * The transaction itself is not kept, block_num and trx_in_block locate it in the pending pool or in its block.
     */
    class transaction_object : public object< transaction_object_type, transaction_object >
    {
@@ -21,16 +23,16 @@ namespace node { namespace chain {
       public:
          template< typename Constructor, typename Allocator >
          transaction_object( Constructor&& c, allocator< Allocator > a )
-            : packed_trx( a )
          {
             c( *this );
          }
 
          id_type              id;
 
-         bip::vector< char, allocator< char > > packed_trx;
          transaction_id_type  trx_id;
          time_point_sec       expiration;
+         uint32_t             block_num = 0;
+         uint32_t             trx_in_block = 0; ///< position in its block, or in the pending pool while pending
    };
 
    struct by_expiration;
@@ -47,5 +49,5 @@ namespace node { namespace chain {
 
 } } // node::chain
 
-FC_REFLECT( node::chain::transaction_object, (id)(packed_trx)(trx_id)(expiration) )
+FC_REFLECT( node::chain::transaction_object, (id)(trx_id)(expiration)(block_num)(trx_in_block) )
 CHAINBASE_SET_INDEX_TYPE( node::chain::transaction_object, node::chain::transaction_index )
@@ -0,0 +1,125 @@
+#include <node/chain/known_id_filter.hpp>
+
+#include <fc/exception/exception.hpp>
+
+namespace node { namespace chain {
+
+namespace {
+
+const uint32_t bits_per_id = 16;
+const uint32_t hashes_per_id = 4;
+
+/**
+ * Ids are hashes already, so the probe positions come straight from their bits. The first word of
+ * a block id is the block number, leave it out.
+ */
+void probe_hashes( const fc::ripemd160& id, uint64_t& h1, uint64_t& h2 )
+{
+   h1 = uint64_t( id._hash[1] ) | ( uint64_t( id._hash[2] ) << 32 );
+   h2 = uint64_t( id._hash[3] ) | ( uint64_t( id._hash[4] ) << 32 ) | 1;
+}
+
+} // anonymous
+
+known_id_filter::known_id_filter( uint32_t capacity )
+   : _capacity( capacity )
+{
+   FC_ASSERT( capacity > 0 );
+
+   uint64_t words = 1;
+   while( words * 64 < uint64_t( capacity ) * bits_per_id )
+      words <<= 1;
+   _word_mask = words - 1;
+
+   for( auto& g : _generations )
+   {
+      g.words.reset( new std::atomic< uint64_t >[ words ] );
+      clear( g );
+   }
+}
+
+void known_id_filter::clear( generation& g )
+{
+   for( uint64_t i = 0; i <= _word_mask; ++i )
+      g.words[i].store( 0, std::memory_order_relaxed );
+   g.count = 0;
+}
+
+void known_id_filter::reset( uint64_t mark )
+{
+   uint64_t seq = _rotations.load( std::memory_order_relaxed );
+   _rotations.store( seq + 1, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_release );
+
+   for( auto& g : _generations )
+      clear( g );
+   _generations[ _current ].first_mark = mark;
+   _covered_from.store( mark, std::memory_order_relaxed );
+   _last_mark.store( mark, std::memory_order_relaxed );
+
+   _rotations.store( seq + 2, std::memory_order_release );
+}
+
+void known_id_filter::insert( const fc::ripemd160& id, uint64_t mark )
+{
+   mark = std::max( mark, _last_mark.load( std::memory_order_relaxed ) );
+   _last_mark.store( mark, std::memory_order_relaxed );
+
+   if( _generations[ _current ].count >= _capacity )
+   {
+      uint64_t seq = _rotations.load( std::memory_order_relaxed );
+      _rotations.store( seq + 1, std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_release );
+
+      // everything dropped with the older generation was inserted no later than the newer one started
+      generation& full = _generations[ _current ];
+      _covered_from.store( std::max( _covered_from.load( std::memory_order_relaxed ), full.first_mark + 1 ), std::memory_order_relaxed );
+      _current = 1 - _current;
+      clear( _generations[ _current ] );
+      _generations[ _current ].first_mark = mark;
+
+      _rotations.store( seq + 2, std::memory_order_release );
+   }
+
+   uint64_t h1, h2;
+   probe_hashes( id, h1, h2 );
+   generation& g = _generations[ _current ];
+   for( uint32_t i = 0; i < hashes_per_id; ++i )
+   {
+      uint64_t bit = ( h1 + i * h2 ) & ( _word_mask * 64 + 63 );
+      g.words[ bit / 64 ].fetch_or( uint64_t( 1 ) << ( bit % 64 ), std::memory_order_relaxed );
+   }
+   ++g.count;
+}
+
+bool known_id_filter::might_contain( const generation& g, uint64_t h1, uint64_t h2 )const
+{
+   for( uint32_t i = 0; i < hashes_per_id; ++i )
+   {
+      uint64_t bit = ( h1 + i * h2 ) & ( _word_mask * 64 + 63 );
+      if( !( g.words[ bit / 64 ].load( std::memory_order_relaxed ) & ( uint64_t( 1 ) << ( bit % 64 ) ) ) )
+         return false;
+   }
+   return true;
+}
+
+bool known_id_filter::excludes( const fc::ripemd160& id, uint64_t since )const
+{
+   uint64_t seq = _rotations.load( std::memory_order_acquire );
+   if( seq & 1 )
+      return false;
+   if( since < _covered_from.load( std::memory_order_relaxed ) )
+      return false;
+
+   uint64_t h1, h2;
+   probe_hashes( id, h1, h2 );
+   bool maybe_present = might_contain( _generations[0], h1, h2 ) || might_contain( _generations[1], h1, h2 );
+
+   std::atomic_thread_fence( std::memory_order_acquire );
+   if( _rotations.load( std::memory_order_relaxed ) != seq )
+      return false;
+
+   return !maybe_present;
+}
+
+} } // node::chain
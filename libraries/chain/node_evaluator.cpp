@@ -349,6 +349,7 @@ void accountUpdate_evaluator::do_apply( const accountUpdate_operation& o )
          if( o.active )  auth.active  = *o.active;
          if( o.posting ) auth.posting = *o.posting;
       });
+      _db.invalidate_cached_authority( o.account );
    }
 
 }
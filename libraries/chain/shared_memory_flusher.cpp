@@ -0,0 +1,119 @@
+#include <node/chain/shared_memory_flusher.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/thread/scoped_lock.hpp>
+
+namespace node { namespace chain {
+
+shared_memory_flusher::~shared_memory_flusher()
+{
+   stop();
+}
+
+void shared_memory_flusher::start( fc::microseconds pass_interval, uint64_t max_bytes_per_second )
+{
+   stop();
+
+   _pass_interval = pass_interval;
+   _max_bytes_per_second = max_bytes_per_second;
+   _stopping = false;
+
+   _thread = std::make_shared< fc::thread >( "shared_memory_flush" );
+   _done = _thread->async( [this]() { run(); }, "shared memory flush loop" );
+}
+
+void shared_memory_flusher::stop()
+{
+   if( !_thread )
+      return;
+
+   _stopping = true;
+   try
+   {
+      _done.wait();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Shared memory flush loop failed: ${e}", ("e", e.to_detail_string()) );
+   }
+   _thread->quit();
+   _thread.reset();
+}
+
+void shared_memory_flusher::pause( int64_t microseconds )
+{
+   // Sleep in slices so stop() does not have to wait out a long pause
+   while( microseconds > 0 && !_stopping )
+   {
+      int64_t slice = std::min< int64_t >( microseconds, 100000 );
+      fc::usleep( fc::microseconds( slice ) );
+      microseconds -= slice;
+   }
+}
+
+void shared_memory_flusher::run()
+{
+   const uint64_t size = _db.segment_size();
+   const uint64_t chunks = std::max< uint64_t >( ( size + chunk_size - 1 ) / chunk_size, 1 );
+
+   int64_t chunk_interval = _pass_interval.count() / chunks;
+   if( _max_bytes_per_second )
+      chunk_interval = std::max< int64_t >( chunk_interval, chunk_size * 1000000 / _max_bytes_per_second );
+
+   while( !_stopping )
+   {
+      fc::time_point pass_start = fc::time_point::now();
+      fc::microseconds flush_time;
+
+      for( uint64_t offset = 0; offset < size && !_stopping; offset += chunk_size )
+      {
+         fc::time_point chunk_start = fc::time_point::now();
+         _db.flush( offset, chunk_size );
+         fc::microseconds duration = fc::time_point::now() - chunk_start;
+         flush_time += duration;
+
+         {
+            fc::scoped_lock< fc::mutex > lock( _stats_mutex );
+            _stats.last_chunk_duration = duration;
+            _stats.max_chunk_duration = std::max( _stats.max_chunk_duration, duration );
+         }
+
+         pause( chunk_interval - duration.count() );
+      }
+
+      if( _stopping )
+         break;
+
+      fc::time_point pass_end = fc::time_point::now();
+      // Reading the dirty page count walks /proc/self/smaps, so it is done here once per pass instead of per get_stats()
+      uint64_t dirty_bytes = _db.dirty_bytes();
+      {
+         fc::scoped_lock< fc::mutex > lock( _stats_mutex );
+         ++_stats.passes;
+         _stats.dirty_bytes = dirty_bytes;
+         _stats.last_pass_duration = pass_end - pass_start;
+         _stats.last_pass_flush_time = flush_time;
+         _stats.last_pass_end = pass_end;
+      }
+
+      ilog( "Flushed shared memory file in ${t} ms (${w} ms writing)",
+         ("t", ( pass_end - pass_start ).count() / 1000)("w", flush_time.count() / 1000) );
+
+      // Nothing to spread a pass over, avoid spinning over clean pages
+      if( chunk_interval <= 0 )
+         pause( 1000000 );
+   }
+}
+
+shared_memory_flush_stats shared_memory_flusher::get_stats()const
+{
+   shared_memory_flush_stats result;
+   {
+      fc::scoped_lock< fc::mutex > lock( _stats_mutex );
+      result = _stats;
+   }
+   result.segment_size = _db.segment_size();
+   return result;
+}
+
+} } // node::chain
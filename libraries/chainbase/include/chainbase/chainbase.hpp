@@ -668,9 +668,28 @@ namespace chainbase {
          void open( const bfs::path& dir, uint32_t write = read_only, uint64_t shared_file_size = 0 );
          void close();
          void flush();
+
+         /**
+          *  Synchronously writes back the dirty pages in [offset, offset + size) of the shared memory
+          *  file. Safe to call from another thread while the database is being modified.
+          *  On Windows the range is handed to the OS for write back but not waited on.
+          */
+         void flush( size_t offset, size_t size );
+
+         size_t segment_size()const { return _segment ? _segment->get_size() : 0; }
+
+         /// Bytes of the mapping modified but not yet written back, where the OS reports it (0 otherwise)
+         size_t dirty_bytes()const;
+
          void wipe( const bfs::path& dir );
          void set_require_locking( bool enable_require_locking );
 
+         /**
+          *  True if the last process to open the shared memory file for writing did not close it,
+          *  e.g. it crashed or was killed. Its contents cannot be trusted in that case.
+          */
+         bool is_dirty()const { return _dirty; }
+
 #ifdef CHAINBASE_CHECK_LOCKING
          void require_lock_fail( const char* method, const char* lock_type, const char* tname )const;
 
@@ -992,6 +1011,7 @@ namespace chainbase {
          unique_ptr<bip::managed_mapped_file>                        _meta;
          read_write_mutex_manager*                                   _rw_manager = nullptr;
          bool                                                        _read_only = false;
+         bool                                                        _dirty = false;
          bip::file_lock                                              _flock;
 
          /**
@@ -1,8 +1,16 @@
 #include <chainbase/chainbase.hpp>
 #include <boost/array.hpp>
 
+#include <cstdio>
+#include <fstream>
 #include <iostream>
 
+#ifndef WIN32
+#include <sys/mman.h>
+#else
+#include <windows.h>
+#endif
+
 namespace chainbase {
 
    struct environment_check {
@@ -30,6 +38,14 @@ namespace chainbase {
       bool                    windows = false;
    };
 
+   /**
+    * Set while a writer has the segment open. Finding it set on open means the previous writer
+    * never reached close(), and the segment may hold a partially applied modification.
+    */
+   struct shutdown_state {
+      bool dirty = false;
+   };
+
    void database::open( const bfs::path& dir, uint32_t flags, uint64_t shared_file_size ) {
 
       bool write = flags & database::read_write;
@@ -42,6 +58,7 @@ namespace chainbase {
       if( _data_dir != dir ) close();
 
       _data_dir = dir;
+      _dirty = false;
       auto abs_path = bfs::absolute( dir / "shared_memory.bin" );
 
       if( bfs::exists( abs_path ) )
@@ -102,6 +119,11 @@ namespace chainbase {
          _flock = bip::file_lock( abs_path.generic_string().c_str() );
          if( !_flock.try_lock() )
             BOOST_THROW_EXCEPTION( std::runtime_error( "could not gain write access to the shared memory file" ) );
+
+         auto state = _segment->find_or_construct< shutdown_state >( "shutdown_state" )();
+         _dirty = state->dirty;
+         state->dirty = true;
+         _segment->flush();
       }
    }
 
@@ -112,8 +134,66 @@ namespace chainbase {
          _meta->flush();
    }
 
+   void database::flush( size_t offset, size_t size ) {
+      size_t total = segment_size();
+      if( offset >= total )
+         return;
+      size = std::min( size, total - offset );
+
+#ifndef WIN32
+      // msync needs a page aligned start, the mapping itself is page aligned
+      size_t page_offset = offset % bip::mapped_region::get_page_size();
+      char* begin = static_cast< char* >( _segment->get_address() ) + offset - page_offset;
+      if( ::msync( begin, size + page_offset, MS_SYNC ) != 0 )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "could not flush shared memory file range" ) );
+#else
+      // Queues the range for write back, the file handle is not ours to FlushFileBuffers, so the
+      // data is only guaranteed on disk after the whole segment is flushed on close
+      char* begin = static_cast< char* >( _segment->get_address() ) + offset;
+      if( !::FlushViewOfFile( begin, size ) )
+         BOOST_THROW_EXCEPTION( std::runtime_error( "could not flush shared memory file range" ) );
+#endif
+   }
+
+   size_t database::dirty_bytes()const {
+      size_t result = 0;
+#ifdef __linux__
+      if( !_segment )
+         return 0;
+
+      unsigned long long base = reinterpret_cast< uintptr_t >( _segment->get_address() );
+      std::ifstream smaps( "/proc/self/smaps" );
+      std::string line;
+      bool in_segment = false;
+      while( std::getline( smaps, line ) )
+      {
+         unsigned long long begin, end;
+         if( sscanf( line.c_str(), "%llx-%llx", &begin, &end ) == 2 )
+         {
+            if( in_segment )
+               break;
+            in_segment = begin <= base && base < end;
+         }
+         else if( in_segment && ( line.compare( 0, 13, "Shared_Dirty:" ) == 0 || line.compare( 0, 14, "Private_Dirty:" ) == 0 ) )
+         {
+            unsigned long long kb = 0;
+            if( sscanf( line.c_str() + line.find( ':' ) + 1, "%llu", &kb ) == 1 )
+               result += kb * 1024;
+         }
+      }
+#endif
+      return result;
+   }
+
    void database::close()
    {
+      // A segment found dirty stays dirty, only wipe() gets rid of it
+      if( _segment && !_read_only && !_dirty )
+      {
+         _segment->flush();
+         _segment->find_or_construct< shutdown_state >( "shutdown_state" )()->dirty = false;
+         _segment->flush();
+      }
       _segment.reset();
       _meta.reset();
       _data_dir = bfs::path();
@@ -136,4 +136,38 @@ BOOST_AUTO_TEST_CASE( open_and_create ) {
    }
 }
 
+BOOST_AUTO_TEST_CASE( dirty_shutdown ) {
+   boost::filesystem::path temp = boost::filesystem::unique_path();
+   try {
+      {
+         chainbase::database db;
+         db.open( temp, database::read_write, 1024*1024*8 );
+         BOOST_CHECK( !db.is_dirty() );
+         db.close();
+      }
+
+      chainbase::database db;
+      db.open( temp, database::read_write );
+      BOOST_CHECK( !db.is_dirty() ); /// closed cleanly
+
+      chainbase::database db2; /// opened for writing while db never closed, as after a crash
+      db2.open( temp, database::read_write );
+      BOOST_CHECK( db2.is_dirty() );
+      db2.close();
+
+      chainbase::database db3; /// stays dirty until wiped
+      db3.open( temp, database::read_write );
+      BOOST_CHECK( db3.is_dirty() );
+      db3.wipe( temp );
+      db3.open( temp, database::read_write, 1024*1024*8 );
+      BOOST_CHECK( !db3.is_dirty() );
+      db3.close();
+      db.close();
+      bfs::remove_all( temp );
+   } catch ( ... ) {
+      bfs::remove_all( temp );
+      throw;
+   }
+}
+
 // BOOST_AUTO_TEST_SUITE_END()
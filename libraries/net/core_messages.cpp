@@ -23,6 +23,8 @@
  */
 #include <graphene/net/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace graphene { namespace net {
 
@@ -45,6 +47,47 @@ namespace graphene { namespace net {
   const core_message_type_enum check_firewall_reply_message::type            = core_message_type_enum::check_firewall_reply_message_type;
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
+  const core_message_type_enum compact_block_message::type                   = core_message_type_enum::compact_block_message_type;
+  const core_message_type_enum get_compact_block_transactions_message::type  = core_message_type_enum::get_compact_block_transactions_message_type;
+  const core_message_type_enum compact_block_transactions_message::type      = core_message_type_enum::compact_block_transactions_message_type;
+
+  message packed_block_message( const std::vector<char>& packed_block, const block_id_type& block_id )
+  {
+    message result;
+    result.msg_type = block_message::type;
+    std::vector<char> packed_id = fc::raw::pack( block_id );
+    result.data.reserve( packed_block.size() + packed_id.size() );
+    result.data.insert( result.data.end(), packed_block.begin(), packed_block.end() );
+    result.data.insert( result.data.end(), packed_id.begin(), packed_id.end() );
+    result.size = (uint32_t)result.data.size();
+    return result;
+  }
+
+  block_id_type block_message_id( const message& block_msg )
+  {
+    FC_ASSERT( block_msg.msg_type == block_message::type && block_msg.data.size() >= sizeof(block_id_type) );
+    block_id_type block_id;
+    fc::datastream<const char*> ds( block_msg.data.data() + block_msg.data.size() - sizeof(block_id_type), sizeof(block_id_type) );
+    fc::raw::unpack( ds, block_id );
+    return block_id;
+  }
+
+  short_transaction_id_type short_transaction_id( const transaction_id_type& trx_id )
+  {
+    short_transaction_id_type result;
+    memcpy( &result, trx_id.data(), sizeof(result) );
+    return result;
+  }
+
+  compact_block_message::compact_block_message( const signed_block& block, const block_id_type& block_id, const item_hash_t& item_hash ) :
+    item_hash(item_hash),
+    block_id(block_id),
+    header(block)
+  {
+    short_ids.reserve( block.transactions.size() );
+    for( const signed_transaction& trx : block.transactions )
+      short_ids.push_back( short_transaction_id( trx.id() ) );
+  }
 
 } } // graphene::net
 
@@ -23,7 +23,28 @@
  */
 #pragma once
 
-#define GRAPHENE_NET_PROTOCOL_VERSION                        106
+#define GRAPHENE_NET_PROTOCOL_VERSION                        110
+
+/**
+ * Peers at this protocol version or later are asked for compact blocks during normal operation
+ */
+#define GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION         107
+
+/**
+ * Messages to peers at this protocol version or later are compressed
+ */
+#define GRAPHENE_NET_COMPRESSION_PROTOCOL_VERSION            108
+
+/**
+ * Peers at this protocol version or later accept transactions they didn't request
+ */
+#define GRAPHENE_NET_TRANSACTION_PUSH_PROTOCOL_VERSION       109
+
+/**
+ * Peers at this protocol version or later are offered blocks before we have applied them.  They
+ * don't disconnect a peer for a block that fails to apply as long as its scheduled witness signed it
+ */
+#define GRAPHENE_NET_EARLY_BLOCK_RELAY_PROTOCOL_VERSION      110
 
 /**
  * Define this to enable debugging code in the p2p network interface.
@@ -37,6 +58,31 @@
  * 2MiB
  */
 #define MAX_MESSAGE_SIZE                                     1024*1024*2
+
+/**
+ * Smaller messages are sent uncompressed, compressing them doesn't pay for the
+ * extra size field and the CPU time
+ */
+#define GRAPHENE_NET_MIN_COMPRESSED_MESSAGE_SIZE             256
+
+/**
+ * Messages from this size on are encrypted and decrypted on the connection's
+ * worker thread, below it the hand-off costs more than the crypto
+ */
+#define GRAPHENE_NET_MIN_OFFLOADED_MESSAGE_SIZE              1024
+
+#define GRAPHENE_NET_DEFAULT_CONNECTION_WORKER_THREADS       2
+
+/**
+ * Most bytes of idle receive buffers kept for reuse, shared by all connections
+ */
+#define GRAPHENE_NET_MESSAGE_BUFFER_POOL_MAX_BYTES           (16*1024*1024)
+
+/**
+ * When pushing transactions is enabled, each peer gets at most this many bytes
+ * of pushed transactions per second, the rest is advertised
+ */
+#define GRAPHENE_NET_DEFAULT_TRANSACTION_PUSH_BYTES_PER_SECOND (16*1024)
 #define GRAPHENE_NET_DEFAULT_PEER_CONNECTION_RETRY_TIME      30 // seconds
 
 /**
@@ -68,6 +114,12 @@
  */
 #define GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS        20
 
+/**
+ * The message cache also drops its oldest messages once they take up more
+ * than this many bytes
+ */
+#define GRAPHENE_NET_DEFAULT_MESSAGE_CACHE_MAX_BYTES         (64*1024*1024)
+
 /**
  * We prevent a peer from offering us a list of blocks which, if we fetched them
  * all, would result in a blockchain that extended into the future.
@@ -81,6 +133,19 @@
 
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * During sync, each peer starts out with this many block requests in flight.
+ * The window grows while the peer answers about as fast as it can, up to
+ * GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING
+ */
+#define GRAPHENE_NET_MIN_SYNC_WINDOW                         10
+
+/**
+ * A sync block we've been waiting on this long (and at least twice the peer's
+ * usual response time) is also requested from a faster peer that has room
+ */
+#define GRAPHENE_NET_SYNC_REQUEST_STALL_TIMEOUT_MS           250
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
 #include <node/protocol/block.hpp>
 
 #include <fc/crypto/ripemd160.hpp>
@@ -44,6 +45,7 @@ namespace graphene { namespace net {
   using node::protocol::block_id_type;
   using node::protocol::transaction_id_type;
   using node::protocol::signed_block;
+  using node::protocol::signed_block_header;
 
   typedef fc::ecc::public_key_data node_id_t;
   typedef fc::ripemd160 item_hash_t;
@@ -86,6 +88,9 @@ namespace graphene { namespace net {
     check_firewall_reply_message_type            = 5015,
     get_current_connections_request_message_type = 5016,
     get_current_connections_reply_message_type   = 5017,
+    compact_block_message_type                   = 5018,
+    get_compact_block_transactions_message_type  = 5019,
+    compact_block_transactions_message_type      = 5020,
     core_message_type_last                       = 5099
   };
 
@@ -115,6 +120,62 @@ namespace graphene { namespace net {
 
    };
 
+   /**
+    *  Frames an already packed signed_block (e.g. read from the block log) as a block_message.
+    *  The result is byte for byte message( block_message( block ) ), without decoding the block.
+    */
+   message packed_block_message( const std::vector<char>& packed_block, const block_id_type& block_id );
+
+   /// The block_id of a block_message, read from the end of the message without decoding the block
+   block_id_type block_message_id( const message& block_msg );
+
+   /// First 8 bytes of a transaction id, enough to tell apart the transactions a peer holds
+   typedef uint64_t short_transaction_id_type;
+   short_transaction_id_type short_transaction_id( const transaction_id_type& trx_id );
+
+   /**
+    *  Sent instead of a block_message in reply to a fetch_items_message for compact_block_message_type,
+    *  which is only requested from peers speaking GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION or later.
+    *  The receiver fills in the transactions from its message cache and asks for the rest with a
+    *  get_compact_block_transactions_message.
+    */
+   struct compact_block_message
+   {
+      static const core_message_type_enum type;
+
+      compact_block_message() {}
+      compact_block_message( const signed_block& block, const block_id_type& block_id, const item_hash_t& item_hash );
+
+      item_hash_t                              item_hash; ///< hash of the block_message this stands in for
+      block_id_type                            block_id;
+      signed_block_header                      header;
+      std::vector<short_transaction_id_type>   short_ids;
+   };
+
+   struct get_compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      get_compact_block_transactions_message() {}
+      get_compact_block_transactions_message( const item_hash_t& item_hash, const block_id_type& block_id, std::vector<uint32_t> indexes ) :
+        item_hash(item_hash),
+        block_id(block_id),
+        indexes(std::move(indexes))
+      {}
+
+      item_hash_t             item_hash;
+      block_id_type           block_id;
+      std::vector<uint32_t>   indexes; ///< positions of the missing transactions in the block
+   };
+
+   struct compact_block_transactions_message
+   {
+      static const core_message_type_enum type;
+
+      item_hash_t                       item_hash;
+      std::vector<signed_transaction>   transactions; ///< in the order they were asked for
+   };
+
   struct item_ids_inventory_message
   {
     static const core_message_type_enum type;
@@ -421,10 +482,16 @@ FC_REFLECT_ENUM( graphene::net::core_message_type_enum,
                  (check_firewall_reply_message_type)
                  (get_current_connections_request_message_type)
                  (get_current_connections_reply_message_type)
+                 (compact_block_message_type)
+                 (get_compact_block_transactions_message_type)
+                 (compact_block_transactions_message_type)
                  (core_message_type_last) )
 
 FC_REFLECT( graphene::net::trx_message, (trx) )
 FC_REFLECT( graphene::net::block_message, (block)(block_id) )
+FC_REFLECT( graphene::net::compact_block_message, (item_hash)(block_id)(header)(short_ids) )
+FC_REFLECT( graphene::net::get_compact_block_transactions_message, (item_hash)(block_id)(indexes) )
+FC_REFLECT( graphene::net::compact_block_transactions_message, (item_hash)(transactions) )
 
 FC_REFLECT( graphene::net::item_id, (item_type)
                                (item_hash) )
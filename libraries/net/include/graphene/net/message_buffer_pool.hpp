@@ -0,0 +1,57 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+namespace graphene { namespace net {
+
+  /// What a message_buffer_pool has handed out and taken back so far
+  struct message_buffer_pool_stats
+  {
+    uint64_t buffers_acquired = 0;
+    uint64_t buffers_allocated = 0; ///< acquisitions the pool had no idle buffer for
+    uint64_t buffers_released = 0;
+    uint64_t buffers_discarded = 0; ///< released buffers freed because they were too small or the pool was full
+    uint64_t idle_bytes = 0;        ///< capacity of the buffers waiting in the pool
+  };
+
+  /**
+   *  Recycles the buffers incoming messages are read, decrypted and decompressed into, so a flood of
+   *  messages during sync doesn't turn into a flood of allocations. Idle buffers are kept in power of
+   *  two size classes by capacity, up to GRAPHENE_NET_MESSAGE_BUFFER_POOL_MAX_BYTES in total.
+   *
+   *  Buffers are decoded on worker threads too, so the pool may be used from any thread.
+   */
+  class message_buffer_pool
+  {
+    public:
+      static message_buffer_pool& instance();
+
+      /// A buffer of size bytes, recycled if the pool has one large enough
+      std::vector<char> acquire(size_t size);
+      /// Takes buffer back for later acquire() calls, leaves it empty
+      void release(std::vector<char>&& buffer);
+
+      message_buffer_pool_stats get_stats() const;
+
+    private:
+      message_buffer_pool() {}
+
+      static const size_t smallest_class_bits = 10; // 1 KiB
+      static const size_t class_count = 12;         // up to 2 MiB, MAX_MESSAGE_SIZE
+
+      mutable std::mutex                                       _mutex;
+      std::array<std::vector<std::vector<char>>, class_count> _idle_buffers;
+      message_buffer_pool_stats                                _stats;
+  };
+
+} } // graphene::net
+
+FC_REFLECT( graphene::net::message_buffer_pool_stats, (buffers_acquired)
+                                                      (buffers_allocated)
+                                                      (buffers_released)
+                                                      (buffers_discarded)
+                                                      (idle_bytes) )
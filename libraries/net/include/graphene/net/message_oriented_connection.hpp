@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
 #include <graphene/net/message.hpp>
 
 namespace graphene { namespace net {
@@ -31,6 +32,15 @@ namespace graphene { namespace net {
 
   class message_oriented_connection;
 
+  /// Payload bytes of the messages that went over the wire compressed, before and after compression
+  struct message_compression_stats
+  {
+    uint64_t uncompressed_bytes_sent = 0;
+    uint64_t compressed_bytes_sent = 0;
+    uint64_t uncompressed_bytes_received = 0;
+    uint64_t compressed_bytes_received = 0;
+  };
+
   /** receives incoming messages from a message_oriented_connection object */
   class message_oriented_connection_delegate 
   {
@@ -52,6 +62,21 @@ namespace graphene { namespace net {
        void connect_to(const fc::ip::endpoint& remote_endpoint);
 
        void send_message(const message& message_to_send);
+
+       /**
+        *  Compresses outgoing messages of at least min_message_size bytes from now on. Only call
+        *  this once the remote side is known to understand compressed messages, which are always
+        *  accepted on receipt.
+        */
+       void enable_compression(uint32_t min_message_size);
+       message_compression_stats get_compression_stats() const;
+
+       /**
+        *  Encrypts, decrypts and (de)compresses the larger messages of this connection on worker_thread,
+        *  which may be shared with other connections. The socket I/O stays on the calling thread.
+        */
+       void set_worker_thread(const std::shared_ptr<fc::thread>& worker_thread);
+
        void close_connection();
        void destroy_connection();
 
@@ -67,3 +92,8 @@ namespace graphene { namespace net {
   typedef std::shared_ptr<message_oriented_connection> message_oriented_connection_ptr;
 
 } } // graphene::net
+
+FC_REFLECT( graphene::net::message_compression_stats, (uncompressed_bytes_sent)
+                                                      (compressed_bytes_sent)
+                                                      (uncompressed_bytes_received)
+                                                      (compressed_bytes_received) )
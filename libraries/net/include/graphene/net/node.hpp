@@ -80,6 +80,24 @@ namespace graphene { namespace net {
          virtual bool handle_block( const graphene::net::block_message& blk_msg, bool sync_mode,
                                     std::vector<fc::uint160_t>& contained_transaction_message_ids ) = 0;
 
+         /**
+          *  @brief Called before handle_block() when blocks are relayed before they are applied
+          *
+          *  Should only do the checks that are cheap compared to applying the block.
+          *
+          *  @throws exception if the block can't be relayed yet
+          */
+         virtual void precheck_block( const graphene::net::block_message& blk_msg ) = 0;
+
+         /**
+          *  @brief Called with a contiguous run of blocks fetched through the sync process, oldest first
+          *
+          *  Every block is attempted. On return results[i] holds the exception blocks[i] was rejected
+          *  with, or is null if it was accepted.
+          */
+         virtual void handle_blocks( const std::vector<graphene::net::block_message>& blk_msgs,
+                                     std::vector<fc::exception_ptr>& results ) = 0;
+
          /**
           *  @brief Called when a new transaction comes in from the network
           *
@@ -40,6 +40,7 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -228,10 +229,19 @@ namespace graphene { namespace net
       bool we_need_sync_items_from_peer = false;
       fc::optional<boost::tuple<std::vector<item_hash_t>, fc::time_point> > item_ids_requested_from_peer; /// we check this to detect a timed-out request and in busy()
       fc::time_point last_sync_item_received_time; /// the time we received the last sync item or the time we sent the last batch of sync item requests to this peer
-      std::set<item_hash_t> sync_items_requested_from_peer; /// ids of blocks we've requested from this peer during sync.  fetch from another peer if this peer disconnects
+      std::map<item_hash_t, fc::time_point> sync_items_requested_from_peer; /// ids of blocks we've requested from this peer during sync and when.  fetch from another peer if this peer disconnects
       item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
       fc::time_point_sec last_block_time_delegate_has_seen;
       bool inhibit_fetching_sync_blocks = false;
+
+      /// how many sync block requests we keep in flight to this peer, adapted by record_sync_item_received()
+      uint32_t sync_window = GRAPHENE_NET_MIN_SYNC_WINDOW;
+      uint64_t sync_items_received = 0;
+      uint64_t sync_requests_reassigned = 0; /// requests that stalled here and were also sent to a faster peer
+      fc::microseconds sync_latency; /// moving average of the time between requesting a sync block and receiving it
+      fc::microseconds sync_min_latency; /// the best response time seen, what the peer does when nothing is queued
+      fc::microseconds sync_item_interval; /// moving average of the time between sync blocks while we're waiting for some
+      fc::time_point last_sync_item_arrival_time;
       /// @}
 
       /// non-synchronization state data
@@ -255,6 +265,21 @@ namespace graphene { namespace net
       timestamped_items_set_type inventory_advertised_to_peer;
 
       item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+      uint64_t transaction_push_budget = 0; /// bytes of transactions we may still push to this peer without advertising them first
+      fc::time_point transaction_push_budget_updated;
+      uint64_t transactions_pushed_to_peer = 0;
+      uint64_t transactions_pushed_by_peer = 0;
+
+      struct compact_block_in_progress
+      {
+        block_id_type         block_id;
+        signed_block          block;
+        std::vector<uint32_t> missing_transactions;
+      };
+      /// compact blocks waiting for the transactions we didn't have, by the hash of the block_message they stand in for.
+      /// An entry lives only as long as the matching request in items_requested_from_peer
+      std::unordered_map<item_hash_t, compact_block_in_progress> compact_blocks_in_progress;
       /// @}
 
       // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -295,6 +320,20 @@ namespace graphene { namespace net
       uint64_t get_total_bytes_sent() const;
       uint64_t get_total_bytes_received() const;
 
+      void enable_compression(uint32_t min_message_size);
+      message_compression_stats get_compression_stats() const;
+      void set_worker_thread(const std::shared_ptr<fc::thread>& worker_thread);
+
+      /**
+       *  Updates the sync throughput estimates with a block requested at request_time which has just
+       *  arrived, and widens the request window (up to maximum_window) while the peer keeps up.
+       */
+      void record_sync_item_received(const fc::time_point& request_time, uint32_t maximum_window);
+      /// Shrinks the request window after requests_reassigned of our sync requests stalled at this peer
+      void record_sync_request_stalled(uint32_t requests_reassigned);
+      /// Measured sync blocks per second, 0 until the peer has sent us one
+      double get_sync_items_per_second() const;
+
       fc::time_point get_last_message_sent_time() const;
       fc::time_point get_last_message_received_time() const;
 
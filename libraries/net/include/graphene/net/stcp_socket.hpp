@@ -53,6 +53,14 @@ class stcp_socket : public virtual fc::iostream
     virtual void     flush();
     virtual void     close();
 
+    /**
+     *  Encrypt/decrypt the next len bytes (a multiple of 16) of the stream, for callers which move
+     *  the ciphertext over get_socket() themselves, e.g. to do the crypto on another thread. Calls
+     *  must follow the order of the data on the wire and not overlap readsome()/writesome().
+     */
+    void             encrypt( const char* plaintext, size_t len, char* ciphertext );
+    void             decrypt( const char* ciphertext, size_t len, char* plaintext );
+
     using istream::get;
     void             get( char& c ) { read( &c, 1 ); }
     fc::sha512       get_shared_secret() const { return _shared_secret; }
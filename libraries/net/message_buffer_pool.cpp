@@ -0,0 +1,68 @@
+#include <graphene/net/message_buffer_pool.hpp>
+#include <graphene/net/config.hpp>
+
+namespace graphene { namespace net {
+
+  message_buffer_pool& message_buffer_pool::instance()
+  {
+    static message_buffer_pool the_pool;
+    return the_pool;
+  }
+
+  std::vector<char> message_buffer_pool::acquire(size_t size)
+  {
+    // the smallest class whose buffers all hold size bytes
+    size_t size_class = 0;
+    while (size_class < class_count && (size_t(1) << (smallest_class_bits + size_class)) < size)
+      ++size_class;
+
+    std::vector<char> buffer;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_stats.buffers_acquired;
+      if (size_class < class_count && !_idle_buffers[size_class].empty())
+      {
+        buffer = std::move(_idle_buffers[size_class].back());
+        _idle_buffers[size_class].pop_back();
+        _stats.idle_bytes -= buffer.capacity();
+      }
+      else
+        ++_stats.buffers_allocated;
+    }
+
+    if (buffer.capacity() == 0 && size_class < class_count)
+      buffer.reserve(size_t(1) << (smallest_class_bits + size_class));
+    buffer.resize(size);
+    return buffer;
+  }
+
+  void message_buffer_pool::release(std::vector<char>&& buffer)
+  {
+    size_t capacity = buffer.capacity();
+    std::vector<char> released(std::move(buffer));
+    buffer.clear();
+    released.clear();
+
+    // the largest class whose size the buffer holds
+    size_t size_class = class_count;
+    while (size_class > 0 && (size_t(1) << (smallest_class_bits + size_class - 1)) > capacity)
+      --size_class;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.buffers_released;
+    if (size_class == 0 || _stats.idle_bytes + capacity > GRAPHENE_NET_MESSAGE_BUFFER_POOL_MAX_BYTES)
+    {
+      ++_stats.buffers_discarded;
+      return; // freed on the way out, after the lock
+    }
+    _idle_buffers[size_class - 1].push_back(std::move(released));
+    _stats.idle_bytes += capacity;
+  }
+
+  message_buffer_pool_stats message_buffer_pool::get_stats() const
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+  }
+
+} } // graphene::net
@@ -29,10 +29,14 @@
 #include <fc/io/enum_type.hpp>
 
 #include <graphene/net/message_oriented_connection.hpp>
+#include <graphene/net/message_buffer_pool.hpp>
 #include <graphene/net/stcp_socket.hpp>
 #include <graphene/net/config.hpp>
 
 #include <atomic>
+#include <future>
+
+#include <zlib.h>
 
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
@@ -48,6 +52,88 @@
 namespace graphene { namespace net {
   namespace detail
   {
+    /**
+     * Set in the msg_type of a message on the wire if its data is a compressed message: the size of
+     * the original data followed by a zlib stream
+     */
+    const uint32_t compressed_message_flag = 0x80000000;
+
+    /// Leaves compressed empty if compression doesn't make the message smaller
+    bool compress_message(const message& message_to_compress, message& compressed)
+    {
+      uint32_t original_size = message_to_compress.size;
+      uLongf compressed_size = compressBound(original_size);
+      compressed.data.resize(sizeof(original_size) + compressed_size);
+      memcpy(compressed.data.data(), &original_size, sizeof(original_size));
+      if (compress2((Bytef*)compressed.data.data() + sizeof(original_size), &compressed_size,
+                    (const Bytef*)message_to_compress.data.data(), original_size, Z_BEST_SPEED) != Z_OK ||
+          sizeof(original_size) + compressed_size >= original_size)
+      {
+        compressed.data.clear();
+        return false;
+      }
+
+      compressed.data.resize(sizeof(original_size) + compressed_size);
+      compressed.size = (uint32_t)compressed.data.size();
+      compressed.msg_type = message_to_compress.msg_type | compressed_message_flag;
+      return true;
+    }
+
+    void decompress_message(message& m)
+    {
+      uint32_t original_size;
+      FC_ASSERT(m.data.size() > sizeof(original_size), "compressed message is too short");
+      memcpy(&original_size, m.data.data(), sizeof(original_size));
+      FC_ASSERT(original_size <= MAX_MESSAGE_SIZE, "", ("original_size", original_size)("MAX_MESSAGE_SIZE", MAX_MESSAGE_SIZE));
+
+      std::vector<char> original = message_buffer_pool::instance().acquire(original_size);
+      uLongf decompressed_size = original_size;
+      int result = uncompress((Bytef*)original.data(), &decompressed_size,
+                              (const Bytef*)m.data.data() + sizeof(original_size), m.data.size() - sizeof(original_size));
+      FC_ASSERT(result == Z_OK && decompressed_size == original_size, "unable to decompress message", ("result", result));
+
+      message_buffer_pool::instance().release(std::move(m.data));
+      m.data = std::move(original);
+      m.size = original_size;
+      m.msg_type &= ~compressed_message_flag;
+    }
+
+    /**
+     * Runs work on worker_thread and waits for it to finish.  Canceling the waiting task does not
+     * stop the work, which may still be using the connection, so the canceled_exception is only
+     * let through once the work is done
+     */
+    template<typename Functor>
+    void run_on_worker_thread(fc::thread& worker_thread, Functor work, const char* description)
+    {
+      auto finished = std::make_shared<std::promise<void>>();
+      std::future<void> work_finished = finished->get_future();
+      // if the task is dropped without running, the promise goes with it and work_finished is ready
+      fc::future<void> work_done = worker_thread.async([work, finished]() {
+        try
+        {
+          work();
+          finished->set_value();
+        }
+        catch (...)
+        {
+          finished->set_exception(std::current_exception());
+          throw;
+        }
+      }, description);
+      finished.reset();
+
+      try
+      {
+        work_done.wait();
+      }
+      catch (const fc::canceled_exception&)
+      {
+        work_finished.wait();
+        throw;
+      }
+    }
+
     class message_oriented_connection_impl
     {
     private:
@@ -63,6 +149,12 @@ namespace graphene { namespace net {
       fc::time_point _last_message_sent_time;
 
       bool _send_message_in_progress;
+
+      uint32_t _min_compressed_message_size = 0; ///< 0 while compression is off
+      message_compression_stats _compression_stats;
+
+      /// encodes and decodes the larger messages of this connection, nullptr to do it on the calling thread
+      std::shared_ptr<fc::thread> _worker_thread;
 #ifndef NDEBUG
       fc::thread* _thread;
 #endif
@@ -80,6 +172,9 @@ namespace graphene { namespace net {
       ~message_oriented_connection_impl();
 
       void send_message(const message& message_to_send);
+      void enable_compression(uint32_t min_message_size);
+      message_compression_stats get_compression_stats() const;
+      void set_worker_thread(const std::shared_ptr<fc::thread>& worker_thread);
       void close_connection();
       void destroy_connection();
 
@@ -149,6 +244,7 @@ namespace graphene { namespace net {
 
       fc::oexception exception_to_rethrow;
       bool call_on_connection_closed = false;
+      message_buffer_pool& receive_buffers = message_buffer_pool::instance();
 
       try
       {
@@ -163,14 +259,42 @@ namespace graphene { namespace net {
           FC_ASSERT( m.size <= MAX_MESSAGE_SIZE, "", ("m.size",m.size)("MAX_MESSAGE_SIZE",MAX_MESSAGE_SIZE) );
 
           size_t remaining_bytes_with_padding = 16 * ((m.size - LEFTOVER + 15) / 16);
-          m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
+          m.data = receive_buffers.acquire(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
           std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
+          std::vector<char> ciphertext = receive_buffers.acquire(remaining_bytes_with_padding);
           if (remaining_bytes_with_padding)
           {
-            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+            _sock.get_socket().read(ciphertext.data(), remaining_bytes_with_padding);
             _bytes_received += remaining_bytes_with_padding;
           }
-          m.data.resize(m.size); // truncate off the padding bytes
+
+          uint32_t size_on_wire = m.size;
+          bool compressed = (m.msg_type & compressed_message_flag) != 0;
+          auto decode_message = [this, remaining_bytes_with_padding, compressed](message& m, std::vector<char>& ciphertext) {
+            if (remaining_bytes_with_padding)
+              _sock.decrypt(ciphertext.data(), remaining_bytes_with_padding, &m.data[LEFTOVER]);
+            m.data.resize(m.size); // truncate off the padding bytes
+            if (compressed)
+              decompress_message(m);
+          };
+          if (_worker_thread && size_on_wire >= GRAPHENE_NET_MIN_OFFLOADED_MESSAGE_SIZE)
+          {
+            // the buffers belong to the worker until it is done with them
+            auto buffers = std::make_shared<std::pair<message, std::vector<char>>>(std::move(m), std::move(ciphertext));
+            run_on_worker_thread(*_worker_thread, [decode_message, buffers]() { decode_message(buffers->first, buffers->second); },
+                                 "decode p2p message");
+            m = std::move(buffers->first);
+            ciphertext = std::move(buffers->second);
+          }
+          else
+            decode_message(m, ciphertext);
+          receive_buffers.release(std::move(ciphertext));
+
+          if (compressed)
+          {
+            _compression_stats.compressed_bytes_received += size_on_wire;
+            _compression_stats.uncompressed_bytes_received += m.size;
+          }
 
           _last_message_received_time = fc::time_point::now();
 
@@ -188,6 +312,8 @@ namespace graphene { namespace net {
             wlog( "message transmission failed ${er}", ("er", e.to_detail_string() ) );
             throw;
           }
+          // the delegate is done with the message, anything it kept is a copy
+          receive_buffers.release(std::move(m.data));
         }
       }
       catch ( const fc::canceled_exception& e )
@@ -255,26 +381,80 @@ namespace graphene { namespace net {
 
       try
       {
-        size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
         if( message_to_send.size > MAX_MESSAGE_SIZE )
            elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-        //pad the message we send to a multiple of 16 bytes
-        size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
 
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
-        size_t toClean = size_with_padding - size_of_message_and_header;
-        memset(paddingSpace, 0, toClean);
+        struct encoded_message
+        {
+          message compressed_message;
+          size_t size_with_padding = 0;
+          std::unique_ptr<char[]> ciphertext;
+        };
+        auto encoded = std::make_shared<encoded_message>();
+        // message_to_send outlives the encoding, run_on_worker_thread doesn't return before it is done
+        const message* message_to_encode = &message_to_send;
+        uint32_t min_compressed_message_size = _min_compressed_message_size;
+        auto encode_message = [this, encoded, message_to_encode, min_compressed_message_size]() {
+          const message& message_to_send = *message_to_encode;
+          message& compressed_message = encoded->compressed_message;
+          if (min_compressed_message_size && message_to_send.size >= min_compressed_message_size)
+            compress_message(message_to_send, compressed_message);
+          const message& message_on_wire = compressed_message.data.empty() ? message_to_send : compressed_message;
+
+          size_t size_of_message_and_header = sizeof(message_header) + message_on_wire.size;
+          //pad the message we send to a multiple of 16 bytes
+          size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
+          encoded->size_with_padding = size_with_padding;
+          std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
+
+          memcpy(padded_message.get(), (char*)&message_on_wire, sizeof(message_header));
+          memcpy(padded_message.get() + sizeof(message_header), message_on_wire.data.data(), message_on_wire.size );
+          char* paddingSpace = padded_message.get() + sizeof(message_header) + message_on_wire.size;
+          size_t toClean = size_with_padding - size_of_message_and_header;
+          memset(paddingSpace, 0, toClean);
+
+          encoded->ciphertext.reset(new char[size_with_padding]);
+          _sock.encrypt(padded_message.get(), size_with_padding, encoded->ciphertext.get());
+        };
+        if (_worker_thread && message_to_send.size >= GRAPHENE_NET_MIN_OFFLOADED_MESSAGE_SIZE)
+          run_on_worker_thread(*_worker_thread, encode_message, "encode p2p message");
+        else
+          encode_message();
+        const message& compressed_message = encoded->compressed_message;
+        size_t size_with_padding = encoded->size_with_padding;
+        const std::unique_ptr<char[]>& ciphertext = encoded->ciphertext;
+
+        if (!compressed_message.data.empty())
+        {
+          _compression_stats.uncompressed_bytes_sent += message_to_send.size;
+          _compression_stats.compressed_bytes_sent += compressed_message.size;
+        }
 
-        _sock.write(padded_message.get(), size_with_padding);
+        _sock.get_socket().write(ciphertext.get(), size_with_padding);
         _sock.flush();
         _bytes_sent += size_with_padding;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
 
+    void message_oriented_connection_impl::enable_compression(uint32_t min_message_size)
+    {
+      VERIFY_CORRECT_THREAD();
+      _min_compressed_message_size = std::max<uint32_t>(min_message_size, 1);
+    }
+
+    message_compression_stats message_oriented_connection_impl::get_compression_stats() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _compression_stats;
+    }
+
+    void message_oriented_connection_impl::set_worker_thread(const std::shared_ptr<fc::thread>& worker_thread)
+    {
+      VERIFY_CORRECT_THREAD();
+      _worker_thread = worker_thread;
+    }
+
     void message_oriented_connection_impl::close_connection()
     {
       VERIFY_CORRECT_THREAD();
@@ -376,6 +556,21 @@ namespace graphene { namespace net {
     my->send_message(message_to_send);
   }
 
+  void message_oriented_connection::enable_compression(uint32_t min_message_size)
+  {
+    my->enable_compression(min_message_size);
+  }
+
+  message_compression_stats message_oriented_connection::get_compression_stats() const
+  {
+    return my->get_compression_stats();
+  }
+
+  void message_oriented_connection::set_worker_thread(const std::shared_ptr<fc::thread>& worker_thread)
+  {
+    my->set_worker_thread(worker_thread);
+  }
+
   void message_oriented_connection::close_connection()
   {
     my->close_connection();
@@ -75,11 +75,14 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/peer_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/message_buffer_pool.hpp>
 #include <graphene/net/config.hpp>
 #include <graphene/net/exceptions.hpp>
 
 #include <node/protocol/config.hpp>
 
+#include <graphene/utilities/trace.hpp>
+
 #include <fc/git_revision.hpp>
 
 //#define ENABLE_DEBUG_ULOGS
@@ -130,16 +133,20 @@ namespace graphene { namespace net {
 
       struct message_hash_index{};
       struct message_contents_hash_index{};
+      struct short_transaction_id_index{};
       struct block_clock_index{};
+      struct insertion_order_index{};
       struct message_info
       {
         message_hash_type message_hash;
         message           message_body;
         uint32_t          block_clock_when_received;
+        size_t            message_size;
 
         // for network performance stats
         message_propagation_data propagation_data;
         fc::uint160_t     message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+        short_transaction_id_type short_transaction_id; // for filling in compact blocks, 0 for anything but transactions
 
         message_info( const message_hash_type& message_hash,
                       const message&           message_body,
@@ -149,8 +156,10 @@ namespace graphene { namespace net {
           message_hash( message_hash ),
           message_body( message_body ),
           block_clock_when_received( block_clock_when_received ),
+          message_size( sizeof(message_header) + message_body.data.size() ),
           propagation_data( propagation_data ),
-          message_contents_hash( message_contents_hash )
+          message_contents_hash( message_contents_hash ),
+          short_transaction_id( message_body.msg_type == trx_message_type ? graphene::net::short_transaction_id( message_contents_hash ) : 0 )
         {}
       };
       typedef boost::multi_index_container
@@ -159,32 +168,82 @@ namespace graphene { namespace net {
                                                   bmi::member<message_info, message_hash_type, &message_info::message_hash> >,
                              bmi::ordered_non_unique< bmi::tag<message_contents_hash_index>,
                                                       bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash> >,
+                             bmi::hashed_non_unique< bmi::tag<short_transaction_id_index>,
+                                                     bmi::member<message_info, short_transaction_id_type, &message_info::short_transaction_id> >,
                              bmi::ordered_non_unique< bmi::tag<block_clock_index>,
-                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> > >
+                                                      bmi::member<message_info, uint32_t, &message_info::block_clock_when_received> >,
+                             bmi::sequenced< bmi::tag<insertion_order_index> > >
         > message_cache_container;
 
       message_cache_container _message_cache;
 
       uint32_t block_clock;
 
+      size_t   _max_bytes;
+      size_t   _bytes;
+      uint64_t _hits;
+      uint64_t _misses;
+      uint64_t _evicted_by_age;
+      uint64_t _evicted_by_size;
+
+      void evict_over_budget();
+
     public:
       blockchain_tied_message_cache() :
-        block_clock( 0 )
+        block_clock( 0 ),
+        _max_bytes( GRAPHENE_NET_DEFAULT_MESSAGE_CACHE_MAX_BYTES ),
+        _bytes( 0 ),
+        _hits( 0 ),
+        _misses( 0 ),
+        _evicted_by_age( 0 ),
+        _evicted_by_size( 0 )
       {}
       void block_accepted();
+      void set_max_bytes( size_t max_bytes );
+      size_t max_bytes() const { return _max_bytes; }
       void cache_message( const message& message_to_cache, const message_hash_type& hash_of_message_to_cache,
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
+      bool has_message( const message_hash_type& hash_of_message_to_lookup ) const;
+      void forget_message( const message_hash_type& hash_of_message_to_forget );
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
+      fc::optional<signed_transaction> get_transaction( short_transaction_id_type short_id ) const;
       size_t size() const { return _message_cache.size(); }
+      fc::variant_object get_statistics() const;
     };
 
     void blockchain_tied_message_cache::block_accepted()
     {
       ++block_clock;
       if( block_clock > cache_duration_in_blocks )
-        _message_cache.get<block_clock_index>().erase(_message_cache.get<block_clock_index>().begin(),
-                                                      _message_cache.get<block_clock_index>().lower_bound(block_clock - cache_duration_in_blocks ) );
+      {
+        auto& by_block_clock = _message_cache.get<block_clock_index>();
+        auto expired_end = by_block_clock.lower_bound( block_clock - cache_duration_in_blocks );
+        for( auto iter = by_block_clock.begin(); iter != expired_end; )
+        {
+          _bytes -= iter->message_size;
+          ++_evicted_by_age;
+          iter = by_block_clock.erase( iter );
+        }
+      }
+    }
+
+    void blockchain_tied_message_cache::set_max_bytes( size_t max_bytes )
+    {
+      _max_bytes = max_bytes;
+      evict_over_budget();
+    }
+
+    // drops the oldest messages until the cache fits its byte budget, but always keeps the newest one
+    void blockchain_tied_message_cache::evict_over_budget()
+    {
+      auto& by_insertion_order = _message_cache.get<insertion_order_index>();
+      while( _bytes > _max_bytes && by_insertion_order.size() > 1 )
+      {
+        _bytes -= by_insertion_order.front().message_size;
+        ++_evicted_by_size;
+        by_insertion_order.pop_front();
+      }
     }
 
     void blockchain_tied_message_cache::cache_message( const message& message_to_cache,
@@ -192,11 +251,16 @@ namespace graphene { namespace net {
                                                      const message_propagation_data& propagation_data,
                                                      const fc::uint160_t& message_content_hash )
     {
-      _message_cache.insert( message_info(hash_of_message_to_cache,
-                                         message_to_cache,
-                                         block_clock,
-                                         propagation_data,
-                                         message_content_hash ) );
+      auto result = _message_cache.insert( message_info(hash_of_message_to_cache,
+                                                        message_to_cache,
+                                                        block_clock,
+                                                        propagation_data,
+                                                        message_content_hash ) );
+      if( result.second )
+      {
+        _bytes += result.first->message_size;
+        evict_over_budget();
+      }
     }
 
     message blockchain_tied_message_cache::get_message( const message_hash_type& hash_of_message_to_lookup )
@@ -204,10 +268,42 @@ namespace graphene { namespace net {
       message_cache_container::index<message_hash_index>::type::const_iterator iter =
          _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
       if( iter != _message_cache.get<message_hash_index>().end() )
+      {
+        ++_hits;
         return iter->message_body;
+      }
+      ++_misses;
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    bool blockchain_tied_message_cache::has_message( const message_hash_type& hash_of_message_to_lookup ) const
+    {
+      return _message_cache.get<message_hash_index>().find( hash_of_message_to_lookup ) != _message_cache.get<message_hash_index>().end();
+    }
+
+    void blockchain_tied_message_cache::forget_message( const message_hash_type& hash_of_message_to_forget )
+    {
+      auto iter = _message_cache.get<message_hash_index>().find( hash_of_message_to_forget );
+      if( iter != _message_cache.get<message_hash_index>().end() )
+      {
+        _bytes -= iter->message_size;
+        _message_cache.get<message_hash_index>().erase( iter );
+      }
+    }
+
+    fc::variant_object blockchain_tied_message_cache::get_statistics() const
+    {
+      fc::mutable_variant_object statistics;
+      statistics["messages"] = _message_cache.size();
+      statistics["bytes"] = _bytes;
+      statistics["max_bytes"] = _max_bytes;
+      statistics["hits"] = _hits;
+      statistics["misses"] = _misses;
+      statistics["evicted_by_age"] = _evicted_by_age;
+      statistics["evicted_by_size"] = _evicted_by_size;
+      return statistics;
+    }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
     {
       if( hash_of_message_contents_to_lookup != fc::uint160_t() )
@@ -220,6 +316,18 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    fc::optional<signed_transaction> blockchain_tied_message_cache::get_transaction( short_transaction_id_type short_id ) const
+    {
+      if( short_id != 0 )
+      {
+        auto range = _message_cache.get<short_transaction_id_index>().equal_range( short_id );
+        for( auto iter = range.first; iter != range.second; ++iter )
+          if( iter->message_body.msg_type == trx_message_type )
+            return iter->message_body.as<trx_message>().trx;
+      }
+      return fc::optional<signed_transaction>();
+    }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     // This specifies configuration info for the local node.  It's stored as JSON
@@ -287,6 +395,8 @@ namespace graphene { namespace net { namespace detail {
 #define NODE_DELEGATE_METHOD_NAMES (has_item) \
                                    (handle_message) \
                                    (handle_block) \
+                                   (precheck_block) \
+                                   (handle_blocks) \
                                    (handle_transaction) \
                                    (get_block_ids) \
                                    (get_item) \
@@ -381,6 +491,8 @@ namespace graphene { namespace net { namespace detail {
       bool has_item( const net::item_id& id ) override;
       void handle_message( const message& ) override;
       bool handle_block( const graphene::net::block_message& block_message, bool sync_mode, std::vector<fc::uint160_t>& contained_transaction_message_ids ) override;
+      void precheck_block( const graphene::net::block_message& block_message ) override;
+      void handle_blocks( const std::vector<graphene::net::block_message>& block_messages, std::vector<fc::exception_ptr>& results ) override;
       void handle_transaction( const graphene::net::trx_message& transaction_message ) override;
       std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t>& blockchain_synopsis,
                                              uint32_t& remaining_item_count,
@@ -443,6 +555,8 @@ namespace graphene { namespace net { namespace detail {
       typedef std::unordered_map<graphene::net::block_id_type, fc::time_point> active_sync_requests_map;
 
       active_sync_requests_map              _active_sync_requests; /// list of sync blocks we've asked for from peers but have not yet received
+      /// stalled sync requests we've sent to a second peer, and whether one of the copies has arrived
+      std::map<graphene::net::block_id_type, bool> _reassigned_sync_items;
       std::list<graphene::net::block_message> _new_received_sync_items; /// list of sync blocks we've just received but haven't yet tried to process
       std::list<graphene::net::block_message> _received_sync_items; /// list of sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
       // @}
@@ -571,6 +685,20 @@ namespace graphene { namespace net { namespace detail {
       unsigned _maximum_number_of_sync_blocks_to_prefetch;
       unsigned _maximum_blocks_per_peer_during_syncing;
 
+      /** relay blocks once their header, signature and merkle root check out rather than after applying them */
+      bool _cut_through_block_relay;
+
+      /** transactions up to this size are pushed to peers in full rather than advertised, 0 disables pushing */
+      uint32_t _transaction_push_max_size;
+      /** how many bytes of pushed transactions each peer may receive per second */
+      uint32_t _transaction_push_bytes_per_second;
+
+      /** threads doing the crypto and compression of large messages, handed out to new connections round-robin.
+       *  Started when the first connection needs one */
+      std::vector<std::shared_ptr<fc::thread> > _connection_worker_threads;
+      uint32_t _connection_worker_thread_count;
+      uint32_t _next_connection_worker;
+
       std::list<fc::future<void> > _handle_message_calls_in_progress;
       std::set<message_hash_type> _message_ids_currently_being_processed;
 
@@ -647,6 +775,24 @@ namespace graphene { namespace net { namespace detail {
       void on_item_not_available_message( peer_connection* originating_peer,
                                           const item_not_available_message& item_not_available_message_received );
 
+      void send_blocks( peer_connection* originating_peer,
+                        const fetch_items_message& fetch_items_message_received );
+      void send_compact_blocks( peer_connection* originating_peer,
+                                const fetch_items_message& fetch_items_message_received );
+
+      void on_compact_block_message( peer_connection* originating_peer,
+                                     const compact_block_message& compact_block_message_received );
+
+      void on_get_compact_block_transactions_message( peer_connection* originating_peer,
+                                                      const get_compact_block_transactions_message& get_compact_block_transactions_message_received );
+
+      void on_compact_block_transactions_message( peer_connection* originating_peer,
+                                                  const compact_block_transactions_message& compact_block_transactions_message_received );
+
+      void process_reconstructed_compact_block( peer_connection* originating_peer, const item_hash_t& block_message_hash, const signed_block& block );
+      void fetch_full_block( peer_connection* originating_peer, const item_hash_t& block_message_hash );
+      void forget_compact_blocks_in_progress( const block_id_type& block_id );
+
       void on_item_ids_inventory_message( peer_connection* originating_peer,
                                           const item_ids_inventory_message& item_ids_inventory_message_received );
 
@@ -675,14 +821,20 @@ namespace graphene { namespace net { namespace detail {
 
       void on_connection_closed(peer_connection* originating_peer) override;
 
-      void send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send);
+      void send_sync_blocks_to_node_delegate(const std::vector<graphene::net::block_message>& blocks_to_send);
+      void process_sync_block_result(const graphene::net::block_message& block_message_sent, const fc::exception_ptr& rejection);
       void process_backlog_of_sync_blocks();
       void trigger_process_backlog_of_sync_blocks();
       void process_block_during_sync(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
       void process_block_during_normal_operation(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
+      bool block_passes_precheck(const graphene::net::block_message& block_message);
+      bool relay_block_before_validation(peer_connection* originating_peer, const graphene::net::block_message& block_message, const fc::time_point& message_receive_time);
+      void withdraw_relayed_block(const graphene::net::block_message& block_message, const message_hash_type& message_hash);
       void process_block_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
 
       void process_ordinary_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
+      bool accept_pushed_transaction(peer_connection* originating_peer, const item_id& pushed_item);
+      void push_transaction_to_peers(const message& trx_message_to_push, const item_id& item);
 
       void start_synchronizing();
       void start_synchronizing_with_peer(const peer_connection_ptr& peer);
@@ -691,6 +843,9 @@ namespace graphene { namespace net { namespace detail {
 
       void close();
 
+      void set_connection_worker_threads(uint32_t num_threads);
+      void assign_connection_worker_thread(const peer_connection_ptr& peer);
+
       void accept_connection_task(peer_connection_ptr new_peer);
       void accept_loop();
       void send_hello_message(const peer_connection_ptr& peer);
@@ -820,7 +975,12 @@ namespace graphene { namespace net { namespace detail {
       _node_is_shutting_down(false),
       _maximum_number_of_blocks_to_handle_at_one_time(MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME),
       _maximum_number_of_sync_blocks_to_prefetch(MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH),
-      _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING)
+      _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING),
+      _cut_through_block_relay(false),
+      _transaction_push_max_size(0),
+      _transaction_push_bytes_per_second(GRAPHENE_NET_DEFAULT_TRANSACTION_PUSH_BYTES_PER_SECOND),
+      _connection_worker_thread_count(GRAPHENE_NET_DEFAULT_CONNECTION_WORKER_THREADS),
+      _next_connection_worker(0)
     {
       _rate_limiter.set_actual_rate_time_constant(fc::seconds(2));
       fc::rand_pseudo_bytes(&_node_id.data[0], (int)_node_id.size());
@@ -1002,7 +1162,7 @@ namespace graphene { namespace net { namespace detail {
       item_id item_id_to_request( graphene::net::block_message_type, item_to_request );
       _active_sync_requests.insert( active_sync_requests_map::value_type(item_to_request, fc::time_point::now() ) );
       peer->last_sync_item_received_time = fc::time_point::now();
-      peer->sync_items_requested_from_peer.insert(item_to_request);
+      peer->sync_items_requested_from_peer[item_to_request] = fc::time_point::now();
       peer->send_message( fetch_items_message(item_id_to_request.item_type, std::vector<item_hash_t>{item_id_to_request.item_hash} ) );
     }
 
@@ -1015,7 +1175,7 @@ namespace graphene { namespace net { namespace detail {
       {
         _active_sync_requests.insert( active_sync_requests_map::value_type(item_to_request, fc::time_point::now() ) );
         peer->last_sync_item_received_time = fc::time_point::now();
-        peer->sync_items_requested_from_peer.insert(item_to_request);
+        peer->sync_items_requested_from_peer[item_to_request] = fc::time_point::now();
       }
       peer->send_message(fetch_items_message(graphene::net::block_message_type, items_to_request));
     }
@@ -1036,39 +1196,97 @@ namespace graphene { namespace net { namespace detail {
             ASSERT_TASK_NOT_PREEMPTED();
             std::set<item_hash_t> sync_items_to_request;
 
-            // for each idle peer that we're syncing with
+            // every peer we're syncing with that has room in its request window, fastest first, so the
+            // blocks we need next come from the peers that will deliver them soonest
+            std::vector<peer_connection_ptr> peers_with_room;
             for( const peer_connection_ptr& peer : _active_connections )
-            {
               if( peer->we_need_sync_items_from_peer &&
-                  sync_item_requests_to_send.find(peer) == sync_item_requests_to_send.end() && // if we've already scheduled a request for this peer, don't consider scheduling another
-                  peer->idle() )
+                  !peer->inhibit_fetching_sync_blocks &&
+                  !peer->item_ids_requested_from_peer &&
+                  peer->items_requested_from_peer.empty() &&
+                  peer->sync_items_requested_from_peer.size() < std::min(peer->sync_window, _maximum_blocks_per_peer_during_syncing) )
+                peers_with_room.push_back(peer);
+            std::stable_sort(peers_with_room.begin(), peers_with_room.end(),
+                             [](const peer_connection_ptr& a, const peer_connection_ptr& b) {
+                               return a->get_sync_items_per_second() > b->get_sync_items_per_second();
+                             });
+
+            for( const peer_connection_ptr& peer : peers_with_room )
+            {
+              size_t room = std::min(peer->sync_window, _maximum_blocks_per_peer_during_syncing) - peer->sync_items_requested_from_peer.size();
+              // loop through the items it has that we don't yet have on our blockchain
+              for( unsigned i = 0; i < peer->ids_of_items_to_get.size() && sync_item_requests_to_send[peer].size() < room; ++i )
               {
-                if (!peer->inhibit_fetching_sync_blocks)
+                item_hash_t item_to_potentially_request = peer->ids_of_items_to_get[i];
+                // if we don't already have this item in our temporary storage and we haven't requested from another syncing peer
+                if( !have_already_received_sync_item(item_to_potentially_request) && // already got it, but for some reson it's still in our list of items to fetch
+                    sync_items_to_request.find(item_to_potentially_request) == sync_items_to_request.end() &&  // we have already decided to request it from another peer during this iteration
+                    _active_sync_requests.find(item_to_potentially_request) == _active_sync_requests.end() ) // we've requested it in a previous iteration and we're still waiting for it to arrive
+                {
+                  // then schedule a request from this peer
+                  sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
+                  sync_items_to_request.insert( item_to_potentially_request );
+                }
+              }
+            }
+
+            // forget reassigned requests once no peer is going to answer them any more
+            for( auto itr = _reassigned_sync_items.begin(); itr != _reassigned_sync_items.end(); )
+            {
+              bool still_requested = false;
+              for( const peer_connection_ptr& peer : _active_connections )
+                if( peer->sync_items_requested_from_peer.find(itr->first) != peer->sync_items_requested_from_peer.end() )
                 {
-                  // loop through the items it has that we don't yet have on our blockchain
-                  for( unsigned i = 0; i < peer->ids_of_items_to_get.size(); ++i )
+                  still_requested = true;
+                  break;
+                }
+              itr = still_requested ? std::next(itr) : _reassigned_sync_items.erase(itr);
+            }
+
+            // a peer that found nothing new to fetch helps out with the requests that are stuck at
+            // slower peers.  Whichever copy arrives first is used, the other one is dropped
+            fc::time_point now = fc::time_point::now();
+            std::map<peer_connection_ptr, uint32_t> stalled_peers; // slow peer -> number of its requests reassigned
+            for( const peer_connection_ptr& peer : peers_with_room )
+            {
+              if( !sync_item_requests_to_send[peer].empty() || peer->sync_items_received == 0 )
+                continue;
+              size_t room = std::min(peer->sync_window, _maximum_blocks_per_peer_during_syncing) - peer->sync_items_requested_from_peer.size();
+              for( const peer_connection_ptr& slow_peer : _active_connections )
+              {
+                if( slow_peer == peer || slow_peer->sync_items_requested_from_peer.empty() ||
+                    slow_peer->get_sync_items_per_second() >= peer->get_sync_items_per_second() )
+                  continue;
+                fc::microseconds stall_timeout = std::max(fc::milliseconds(GRAPHENE_NET_SYNC_REQUEST_STALL_TIMEOUT_MS),
+                                                          fc::microseconds(2 * slow_peer->sync_latency.count()));
+                for( const auto& requested_item : slow_peer->sync_items_requested_from_peer )
+                  if( sync_item_requests_to_send[peer].size() < room &&
+                      now - requested_item.second > stall_timeout &&
+                      _reassigned_sync_items.find(requested_item.first) == _reassigned_sync_items.end() && // only ever ask a second peer
+                      !have_already_received_sync_item(requested_item.first) &&
+                      sync_items_to_request.find(requested_item.first) == sync_items_to_request.end() &&
+                      peer->sync_items_requested_from_peer.find(requested_item.first) == peer->sync_items_requested_from_peer.end() &&
+                      std::find(peer->ids_of_items_to_get.begin(), peer->ids_of_items_to_get.end(), requested_item.first) != peer->ids_of_items_to_get.end() )
                   {
-                    item_hash_t item_to_potentially_request = peer->ids_of_items_to_get[i];
-                    // if we don't already have this item in our temporary storage and we haven't requested from another syncing peer
-                    if( !have_already_received_sync_item(item_to_potentially_request) && // already got it, but for some reson it's still in our list of items to fetch
-                        sync_items_to_request.find(item_to_potentially_request) == sync_items_to_request.end() &&  // we have already decided to request it from another peer during this iteration
-                        _active_sync_requests.find(item_to_potentially_request) == _active_sync_requests.end() ) // we've requested it in a previous iteration and we're still waiting for it to arrive
-                    {
-                      // then schedule a request from this peer
-                      sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
-                      sync_items_to_request.insert( item_to_potentially_request );
-                      if (sync_item_requests_to_send[peer].size() >= _maximum_blocks_per_peer_during_syncing)
-                        break;
-                    }
+                    sync_item_requests_to_send[peer].push_back(requested_item.first);
+                    sync_items_to_request.insert(requested_item.first);
+                    _reassigned_sync_items[requested_item.first] = false;
+                    ++stalled_peers[slow_peer];
                   }
-                }
               }
             }
+            for( const auto& stalled_peer : stalled_peers )
+            {
+              fc_dlog(fc::logger::get("sync"), "${count} requests to peer ${peer} stalled, also requesting them from faster peers",
+                      ("count", stalled_peer.second)("peer", stalled_peer.first->get_remote_endpoint()));
+              stalled_peer.first->record_sync_request_stalled(stalled_peer.second);
+            }
           } // end non-preemptable section
 
           // make all the requests we scheduled in the loop above
           for( auto sync_item_request : sync_item_requests_to_send )
-            request_sync_items_from_peer( sync_item_request.first, sync_item_request.second );
+            if( !sync_item_request.second.empty() )
+              request_sync_items_from_peer( sync_item_request.first, sync_item_request.second );
           sync_item_requests_to_send.clear();
         }
         else
@@ -1078,7 +1296,17 @@ namespace graphene { namespace net { namespace detail {
         {
           dlog( "no sync items to fetch right now, going to sleep" );
           _retrigger_fetch_sync_items_loop_promise = fc::promise<void>::ptr( new fc::promise<void>("graphene::net::retrigger_fetch_sync_items_loop") );
-          _retrigger_fetch_sync_items_loop_promise->wait();
+          try
+          {
+            // while requests are outstanding, wake up now and then to look for stalled ones
+            if( _active_sync_requests.empty() )
+              _retrigger_fetch_sync_items_loop_promise->wait();
+            else
+              _retrigger_fetch_sync_items_loop_promise->wait(fc::milliseconds(GRAPHENE_NET_SYNC_REQUEST_STALL_TIMEOUT_MS));
+          }
+          catch (const fc::timeout_exception&)
+          {
+          }
           _retrigger_fetch_sync_items_loop_promise.reset();
         }
       } // while( !canceled )
@@ -1204,7 +1432,14 @@ namespace graphene { namespace net { namespace detail {
                         ("endpoint", peer_and_items.peer->get_remote_endpoint())("id", id));
               }
 
-            peer_and_items.peer->send_message(fetch_items_message(items_by_type.first,
+            // the item stays a block_message_type item in items_requested_from_peer, peers which know
+            // compact blocks are only asked to send it in that form
+            uint32_t item_type_to_request = items_by_type.first;
+            if (item_type_to_request == core_message_type_enum::block_message_type &&
+                peer_and_items.peer->core_protocol_version >= GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION)
+              item_type_to_request = core_message_type_enum::compact_block_message_type;
+
+            peer_and_items.peer->send_message(fetch_items_message(item_type_to_request,
                                                                   items_by_type.second));
           }
         }
@@ -1410,6 +1645,14 @@ namespace graphene { namespace net { namespace detail {
                       ("synopsis", active_peer->item_ids_requested_from_peer->get<0>()));
                 disconnect_due_to_request_timeout = true;
               }
+            // a compact block whose request expired or was answered some other way will never be completed
+            for (auto iter = active_peer->compact_blocks_in_progress.begin(); iter != active_peer->compact_blocks_in_progress.end();)
+            {
+              if (active_peer->items_requested_from_peer.find(item_id(block_message_type, iter->first)) == active_peer->items_requested_from_peer.end())
+                iter = active_peer->compact_blocks_in_progress.erase(iter);
+              else
+                ++iter;
+            }
             if (!disconnect_due_to_request_timeout)
               for (const peer_connection::item_to_time_map_type::value_type& item_and_time : active_peer->items_requested_from_peer)
                 if (item_and_time.second < active_ignored_request_threshold)
@@ -1815,6 +2058,15 @@ namespace graphene { namespace net { namespace detail {
       case core_message_type_enum::block_message_type:
         process_block_message(originating_peer, received_message, message_hash);
         break;
+      case core_message_type_enum::compact_block_message_type:
+        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+        break;
+      case core_message_type_enum::get_compact_block_transactions_message_type:
+        on_get_compact_block_transactions_message(originating_peer, received_message.as<get_compact_block_transactions_message>());
+        break;
+      case core_message_type_enum::compact_block_transactions_message_type:
+        on_compact_block_transactions_message(originating_peer, received_message.as<compact_block_transactions_message>());
+        break;
       case core_message_type_enum::current_time_request_message_type:
         on_current_time_request_message(originating_peer, received_message.as<current_time_request_message>());
         break;
@@ -1930,6 +2182,8 @@ namespace graphene { namespace net { namespace detail {
       originating_peer->node_public_key = hello_message_received.node_public_key;
       originating_peer->node_id = hello_message_received.node_public_key; // will probably be overwritten in parse_hello_user_data_for_peer()
       originating_peer->core_protocol_version = hello_message_received.core_protocol_version;
+      if (originating_peer->core_protocol_version >= GRAPHENE_NET_COMPRESSION_PROTOCOL_VERSION)
+        originating_peer->enable_compression(GRAPHENE_NET_MIN_COMPRESSED_MESSAGE_SIZE);
       originating_peer->inbound_address = hello_message_received.inbound_address;
       originating_peer->inbound_port = hello_message_received.inbound_port;
       originating_peer->outbound_port = hello_message_received.outbound_port;
@@ -2777,7 +3031,16 @@ namespace graphene { namespace net { namespace detail {
            ("type", fetch_items_message_received.item_type)
            ("endpoint", originating_peer->get_remote_endpoint()));
 
-      fc::optional<message> last_block_message_sent;
+      if (fetch_items_message_received.item_type == core_message_type_enum::compact_block_message_type)
+      {
+        send_compact_blocks(originating_peer, fetch_items_message_received);
+        return;
+      }
+      if (fetch_items_message_received.item_type == block_message_type)
+      {
+        send_blocks(originating_peer, fetch_items_message_received);
+        return;
+      }
 
       std::list<message> reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
@@ -2789,8 +3052,6 @@ namespace graphene { namespace net { namespace detail {
                ("endpoint", originating_peer->get_remote_endpoint())
                ("id", requested_message.id()));
           reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2807,8 +3068,6 @@ namespace graphene { namespace net { namespace detail {
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
           reply_messages.push_back(requested_message);
-          if (fetch_items_message_received.item_type == block_message_type)
-            last_block_message_sent = requested_message;
           continue;
         }
         catch (fc::key_not_found_exception&)
@@ -2819,20 +3078,257 @@ namespace graphene { namespace net { namespace detail {
         }
       }
 
+      for (const message& reply : reply_messages)
+        originating_peer->send_message(reply);
+    }
+
+    /**
+     * Blocks are queued by id and only read from the chain (as the packed bytes, see get_item())
+     * when it is their turn to be sent, so a peer asking for a long run of old blocks doesn't make us
+     * load and decode all of them up front.
+     */
+    void node_impl::send_blocks(peer_connection* originating_peer, const fetch_items_message& fetch_items_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::optional<block_id_type> last_block_id_sent;
+      for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
+      {
+        // during normal operation blocks are requested by message hash, during sync by block id
+        block_id_type block_id;
+        try
+        {
+          message cached_block = _message_cache.get_message(item_hash);
+          if (_message_ids_currently_being_processed.find(item_hash) != _message_ids_currently_being_processed.end())
+          {
+            // relayed before it was applied, the chain can't serve it yet
+            originating_peer->send_message(cached_block);
+            continue;
+          }
+          block_id = block_message_id(cached_block);
+        }
+        catch (fc::key_not_found_exception&)
+        {
+          item_id item_to_fetch(block_message_type, item_hash);
+          if (!_delegate->has_item(item_to_fetch))
+          {
+            dlog("received block request from peer ${endpoint} but we don't have it",
+                 ("endpoint", originating_peer->get_remote_endpoint()));
+            originating_peer->send_message(item_not_available_message(item_to_fetch));
+            continue;
+          }
+          block_id = item_hash;
+        }
+        originating_peer->send_item(item_id(block_message_type, block_id));
+        last_block_id_sent = block_id;
+      }
+
       // if we sent them a block, update our record of the last block they've seen accordingly
-      if (last_block_message_sent)
+      if (last_block_id_sent)
       {
-        graphene::net::block_message block = last_block_message_sent->as<graphene::net::block_message>();
-        originating_peer->last_block_delegate_has_seen = block.block_id;
-        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
+        originating_peer->last_block_delegate_has_seen = *last_block_id_sent;
+        originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(*last_block_id_sent);
+      }
+    }
+
+    void node_impl::send_compact_blocks(peer_connection* originating_peer, const fetch_items_message& fetch_items_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::optional<graphene::net::block_message> last_block_sent;
+      std::list<message> reply_messages;
+      for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
+      {
+        // blocks we advertised are in the message cache, the client only knows them by block id
+        item_id requested_item(block_message_type, item_hash);
+        message requested_message;
+        try
+        {
+          requested_message = _message_cache.get_message(item_hash);
+        }
+        catch (fc::key_not_found_exception&)
+        {}
+        if (requested_message.msg_type != block_message_type)
+        {
+          dlog("received compact block request from peer ${endpoint} but we don't have it",
+               ("endpoint", originating_peer->get_remote_endpoint()));
+          reply_messages.push_back(item_not_available_message(requested_item));
+          continue;
+        }
+
+        graphene::net::block_message block = requested_message.as<graphene::net::block_message>();
+        reply_messages.push_back(compact_block_message(block.block, block.block_id, item_hash));
+        last_block_sent = std::move(block);
+      }
+
+      if (last_block_sent)
+      {
+        originating_peer->last_block_delegate_has_seen = last_block_sent->block_id;
+        originating_peer->last_block_time_delegate_has_seen = last_block_sent->block.timestamp;
       }
 
       for (const message& reply : reply_messages)
+        originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_compact_block_message(peer_connection* originating_peer, const compact_block_message& compact_block_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& item_hash = compact_block_message_received.item_hash;
+      if (originating_peer->items_requested_from_peer.find(item_id(block_message_type, item_hash)) == originating_peer->items_requested_from_peer.end())
       {
-        if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        wlog("received a compact block ${id} we didn't ask for from peer ${endpoint}, ignoring it",
+             ("id", compact_block_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+
+      peer_connection::compact_block_in_progress in_progress;
+      in_progress.block_id = compact_block_message_received.block_id;
+      signed_block& block = in_progress.block;
+      static_cast<signed_block_header&>(block) = compact_block_message_received.header;
+      block.transactions.resize(compact_block_message_received.short_ids.size());
+      for (uint32_t i = 0; i < compact_block_message_received.short_ids.size(); ++i)
+      {
+        fc::optional<signed_transaction> trx = _message_cache.get_transaction(compact_block_message_received.short_ids[i]);
+        if (trx)
+          block.transactions[i] = std::move(*trx);
         else
-          originating_peer->send_message(reply);
+          in_progress.missing_transactions.push_back(i);
+      }
+
+      if (in_progress.missing_transactions.empty())
+      {
+        process_reconstructed_compact_block(originating_peer, item_hash, block);
+        return;
+      }
+
+      dlog("compact block ${id} from peer ${endpoint} is missing ${missing} of ${count} transactions",
+           ("id", compact_block_message_received.block_id)("endpoint", originating_peer->get_remote_endpoint())
+           ("missing", in_progress.missing_transactions.size())("count", block.transactions.size()));
+      originating_peer->send_message(get_compact_block_transactions_message(item_hash, compact_block_message_received.block_id,
+                                                                            in_progress.missing_transactions));
+      originating_peer->compact_blocks_in_progress[item_hash] = std::move(in_progress);
+    }
+
+    void node_impl::on_get_compact_block_transactions_message(peer_connection* originating_peer,
+                                                              const get_compact_block_transactions_message& get_compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& item_hash = get_compact_block_transactions_message_received.item_hash;
+
+      // the block is normally still in the message cache, otherwise ask the client for it by id
+      message block_to_send;
+      try
+      {
+        block_to_send = _message_cache.get_message(item_hash);
+      }
+      catch (fc::key_not_found_exception&)
+      {
+        try
+        {
+          block_to_send = _delegate->get_item(item_id(block_message_type, get_compact_block_transactions_message_received.block_id));
+        }
+        catch (const fc::exception&)
+        {}
+      }
+      if (block_to_send.msg_type != block_message_type)
+      {
+        originating_peer->send_message(item_not_available_message(item_id(block_message_type, item_hash)));
+        return;
+      }
+
+      graphene::net::block_message block = block_to_send.as<graphene::net::block_message>();
+      compact_block_transactions_message reply;
+      reply.item_hash = item_hash;
+      reply.transactions.reserve(get_compact_block_transactions_message_received.indexes.size());
+      for (uint32_t index : get_compact_block_transactions_message_received.indexes)
+      {
+        if (index >= block.block.transactions.size())
+        {
+          wlog("peer ${endpoint} asked for transaction ${index} of a block with only ${count}",
+               ("endpoint", originating_peer->get_remote_endpoint())("index", index)("count", block.block.transactions.size()));
+          originating_peer->send_message(item_not_available_message(item_id(block_message_type, item_hash)));
+          return;
+        }
+        reply.transactions.push_back(block.block.transactions[index]);
+      }
+      originating_peer->send_message(reply);
+    }
+
+    void node_impl::on_compact_block_transactions_message(peer_connection* originating_peer,
+                                                          const compact_block_transactions_message& compact_block_transactions_message_received)
+    {
+      VERIFY_CORRECT_THREAD();
+      const item_hash_t& item_hash = compact_block_transactions_message_received.item_hash;
+      auto in_progress_iter = originating_peer->compact_blocks_in_progress.find(item_hash);
+      if (in_progress_iter == originating_peer->compact_blocks_in_progress.end())
+      {
+        wlog("received compact block transactions we didn't ask for from peer ${endpoint}, ignoring them",
+             ("endpoint", originating_peer->get_remote_endpoint()));
+        return;
+      }
+
+      peer_connection::compact_block_in_progress in_progress = std::move(in_progress_iter->second);
+      originating_peer->compact_blocks_in_progress.erase(in_progress_iter);
+
+      const std::vector<signed_transaction>& transactions = compact_block_transactions_message_received.transactions;
+      if (transactions.size() != in_progress.missing_transactions.size())
+      {
+        fetch_full_block(originating_peer, item_hash);
+        return;
+      }
+
+      for (size_t i = 0; i < transactions.size(); ++i)
+        in_progress.block.transactions[in_progress.missing_transactions[i]] = transactions[i];
+
+      process_reconstructed_compact_block(originating_peer, item_hash, in_progress.block);
+    }
+
+    void node_impl::process_reconstructed_compact_block(peer_connection* originating_peer, const item_hash_t& block_message_hash, const signed_block& block)
+    {
+      VERIFY_CORRECT_THREAD();
+      // a short id matching the wrong transaction shows up as a different merkle root, and any
+      // other difference from the block the peer has as a different message hash
+      if (block.calculate_merkle_root() != block.transaction_merkle_root)
+      {
+        dlog("compact block ${num} from peer ${endpoint} did not match its merkle root",
+             ("num", block.block_num())("endpoint", originating_peer->get_remote_endpoint()));
+        fetch_full_block(originating_peer, block_message_hash);
+        return;
+      }
+
+      message block_message_to_process(graphene::net::block_message(block));
+      if (block_message_to_process.id() != block_message_hash)
+      {
+        fetch_full_block(originating_peer, block_message_hash);
+        return;
+      }
+
+      process_block_message(originating_peer, block_message_to_process, block_message_hash);
+    }
+
+    void node_impl::fetch_full_block(peer_connection* originating_peer, const item_hash_t& block_message_hash)
+    {
+      VERIFY_CORRECT_THREAD();
+      // the request in items_requested_from_peer is still open, so the block_message is processed as usual
+      dlog("requesting the full block ${hash} from peer ${endpoint}",
+           ("hash", block_message_hash)("endpoint", originating_peer->get_remote_endpoint()));
+      originating_peer->send_message(fetch_items_message(block_message_type, std::vector<item_hash_t>{block_message_hash}));
+    }
+
+    // the block was accepted, whichever peer it came from, so the transactions still missing from
+    // any compact copy of it are no longer needed
+    void node_impl::forget_compact_blocks_in_progress(const block_id_type& block_id)
+    {
+      VERIFY_CORRECT_THREAD();
+      for (const peer_connection_ptr& peer : _active_connections)
+      {
+        ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
+        for (auto iter = peer->compact_blocks_in_progress.begin(); iter != peer->compact_blocks_in_progress.end();)
+        {
+          if (iter->second.block_id == block_id)
+            iter = peer->compact_blocks_in_progress.erase(iter);
+          else
+            ++iter;
+        }
       }
     }
 
@@ -2845,6 +3341,7 @@ namespace graphene { namespace net { namespace detail {
       {
         originating_peer->items_requested_from_peer.erase( regular_item_iter );
         originating_peer->inventory_peer_advertised_to_us.erase( requested_item );
+        originating_peer->compact_blocks_in_progress.erase( requested_item.item_hash );
         if (is_item_in_any_peers_inventory(requested_item))
           _items_to_fetch.insert(prioritized_item_id(requested_item, _items_to_fetch_sequence_counter++));
         wlog("Peer doesn't have the requested item.");
@@ -3048,8 +3545,8 @@ namespace graphene { namespace net { namespace detail {
       // received yet, reschedule them to be fetched from another peer
       if (!originating_peer->sync_items_requested_from_peer.empty())
       {
-        for (auto sync_item : originating_peer->sync_items_requested_from_peer)
-          _active_sync_requests.erase(sync_item);
+        for (const auto& sync_item : originating_peer->sync_items_requested_from_peer)
+          _active_sync_requests.erase(sync_item.first);
         trigger_fetch_sync_items_loop();
       }
 
@@ -3066,9 +3563,48 @@ namespace graphene { namespace net { namespace detail {
       schedule_peer_for_deletion(originating_peer_ptr);
     }
 
-    void node_impl::send_sync_block_to_node_delegate(const graphene::net::block_message& block_message_to_send)
+    /**
+     * Hands a contiguous run of sync blocks to the client in one call, so it can apply them under a
+     * single lock, then processes the outcome of each block as if it had been pushed on its own.
+     */
+    void node_impl::send_sync_blocks_to_node_delegate(const std::vector<graphene::net::block_message>& blocks_to_send)
+    {
+      dlog("in send_sync_blocks_to_node_delegate(), ${count} blocks", ("count", blocks_to_send.size()));
+      TRACE_SPAN( "p2p send_sync_blocks_to_node_delegate", int64_t( blocks_to_send.size() ) );
+
+      std::vector<fc::exception_ptr> results;
+      try
+      {
+        fc_ilog(fc::logger::get("sync"),
+                "p2p pushing sync blocks #${first} to #${last}",
+                ("first", blocks_to_send.front().block.block_num())
+                ("last", blocks_to_send.back().block.block_num()));
+        _delegate->handle_blocks(blocks_to_send, results);
+      }
+      catch (const fc::canceled_exception&)
+      {
+        throw;
+      }
+      catch (const fc::exception& e)
+      {
+        results.assign(blocks_to_send.size(), e.dynamic_copy_exception());
+      }
+      results.resize(blocks_to_send.size());
+
+      for (size_t i = 0; i < blocks_to_send.size(); ++i)
+        process_sync_block_result(blocks_to_send[i], results[i]);
+
+      dlog("Leaving send_sync_blocks_to_node_delegate");
+
+      if (// _suspend_fetching_sync_blocks && <-- you can use this if "maximum_number_of_blocks_to_handle_at_one_time" == "maximum_number_of_sync_blocks_to_prefetch"
+          !_node_is_shutting_down &&
+          (!_process_backlog_of_sync_blocks_done.valid() || _process_backlog_of_sync_blocks_done.ready()))
+        _process_backlog_of_sync_blocks_done = fc::async([=](){ process_backlog_of_sync_blocks(); },
+                                                         "process_backlog_of_sync_blocks");
+    }
+
+    void node_impl::process_sync_block_result(const graphene::net::block_message& block_message_to_send, const fc::exception_ptr& rejection)
     {
-      dlog("in send_sync_block_to_node_delegate()");
       bool client_accepted_block = false;
       bool discontinue_fetching_blocks_from_peer = false;
 
@@ -3076,16 +3612,13 @@ namespace graphene { namespace net { namespace detail {
 
       try
       {
-        std::vector<fc::uint160_t> contained_transaction_message_ids;
-        fc_ilog(fc::logger::get("sync"),
-                "p2p pushing sync block #${block_num} ${block_hash}",
-                ("block_num", block_message_to_send.block.block_num())
-                ("block_hash", block_message_to_send.block_id));
-        _delegate->handle_block(block_message_to_send, true, contained_transaction_message_ids);
+        if (rejection)
+          rejection->dynamic_rethrow_exception();
         ilog("Successfully pushed sync block ${num} (id:${id})",
              ("num", block_message_to_send.block.block_num())
              ("id", block_message_to_send.block_id));
         _most_recent_blocks_accepted.push_back(block_message_to_send.block_id);
+        forget_compact_blocks_in_progress(block_message_to_send.block_id);
 
         client_accepted_block = true;
       }
@@ -3240,19 +3773,12 @@ namespace graphene { namespace net { namespace detail {
 
       for (const peer_connection_ptr& peer : peers_we_need_to_sync_to)
         start_synchronizing_with_peer(peer);
-
-      dlog("Leaving send_sync_block_to_node_delegate");
-
-      if (// _suspend_fetching_sync_blocks && <-- you can use this if "maximum_number_of_blocks_to_handle_at_one_time" == "maximum_number_of_sync_blocks_to_prefetch"
-          !_node_is_shutting_down &&
-          (!_process_backlog_of_sync_blocks_done.valid() || _process_backlog_of_sync_blocks_done.ready()))
-        _process_backlog_of_sync_blocks_done = fc::async([=](){ process_backlog_of_sync_blocks(); },
-                                                         "process_backlog_of_sync_blocks");
     }
 
     void node_impl::process_backlog_of_sync_blocks()
     {
       VERIFY_CORRECT_THREAD();
+      TRACE_SPAN( "p2p process_backlog_of_sync_blocks" );
       // garbage-collect the list of async tasks here for lack of a better place
       for (auto calls_iter = _handle_message_calls_in_progress.begin();
             calls_iter != _handle_message_calls_in_progress.end();)
@@ -3264,18 +3790,17 @@ namespace graphene { namespace net { namespace detail {
       }
 
       dlog("in process_backlog_of_sync_blocks");
-      if (_handle_message_calls_in_progress.size() >= _maximum_number_of_blocks_to_handle_at_one_time)
+      // blocks are handed to the client in batches of up to _maximum_number_of_blocks_to_handle_at_one_time,
+      // one batch at a time
+      if (!_handle_message_calls_in_progress.empty())
       {
-        dlog("leaving process_backlog_of_sync_blocks because we're already processing too many blocks");
-        return; // we will be rescheduled when the next block finishes its processing
+        dlog("leaving process_backlog_of_sync_blocks because a batch of blocks is still being processed");
+        return; // we will be rescheduled when the batch finishes its processing
       }
-      dlog("currently ${count} blocks in the process of being handled", ("count", _handle_message_calls_in_progress.size()));
-
 
       if (_suspend_fetching_sync_blocks)
       {
-        dlog("resuming processing sync block backlog because we only ${count} blocks in progress",
-             ("count", _handle_message_calls_in_progress.size()));
+        dlog("resuming processing sync block backlog because no blocks are in progress");
         _suspend_fetching_sync_blocks = false;
       }
 
@@ -3292,6 +3817,7 @@ namespace graphene { namespace net { namespace detail {
       std::set<peer_connection_ptr> peers_with_newly_empty_item_lists;
       std::set<peer_connection_ptr> peers_we_need_to_sync_to;
       std::map<peer_connection_ptr, fc::oexception> peers_with_rejected_block;
+      std::vector<graphene::net::block_message> blocks_to_push;
 
       do
       {
@@ -3333,11 +3859,8 @@ namespace graphene { namespace net { namespace detail {
             if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
                           received_block_iter->block_id) == _most_recent_blocks_accepted.end())
             {
-              graphene::net::block_message block_message_to_process = *received_block_iter;
+              blocks_to_push.push_back(*received_block_iter);
               _received_sync_items.erase(received_block_iter);
-              _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process](){
-                send_sync_block_to_node_delegate(block_message_to_process);
-              }, "send_sync_block_to_node_delegate"));
               ++blocks_processed;
               block_processed_this_iteration = true;
             }
@@ -3356,7 +3879,7 @@ namespace graphene { namespace net { namespace detail {
 
                   // if we just processed the last item in our list from this peer, we will want to
                   // send another request to find out if we are now in sync (this is normally handled in
-                  // send_sync_block_to_node_delegate)
+                  // process_sync_block_result)
                   if (peer->ids_of_items_to_get.empty() &&
                       peer->number_of_unfetched_item_ids == 0 &&
                       peer->ids_of_items_being_processed.empty())
@@ -3374,18 +3897,21 @@ namespace graphene { namespace net { namespace detail {
           } // end if potential_first_block
         } // end for each block in _received_sync_items
 
-        if (_handle_message_calls_in_progress.size() >= _maximum_number_of_blocks_to_handle_at_one_time)
+        if (blocks_to_push.size() >= _maximum_number_of_blocks_to_handle_at_one_time)
         {
-          dlog("stopping processing sync block backlog because we have ${count} blocks in progress",
-               ("count", _handle_message_calls_in_progress.size()));
-          //ulog("stopping processing sync block backlog because we have ${count} blocks in progress, total on hand: ${received}",
-          //     ("count", _handle_message_calls_in_progress.size())("received", _received_sync_items.size()));
+          dlog("stopping processing sync block backlog because we have a full batch of ${count} blocks",
+               ("count", blocks_to_push.size()));
           if (_received_sync_items.size() >= _maximum_number_of_sync_blocks_to_prefetch)
             _suspend_fetching_sync_blocks = true;
           break;
         }
       } while (block_processed_this_iteration);
 
+      if (!blocks_to_push.empty())
+        _handle_message_calls_in_progress.emplace_back(fc::async([this, blocks_to_push](){
+          send_sync_blocks_to_node_delegate(blocks_to_push);
+        }, "send_sync_blocks_to_node_delegate"));
+
       dlog("leaving process_backlog_of_sync_blocks, ${count} processed", ("count", blocks_processed));
 
       if (!_suspend_fetching_sync_blocks)
@@ -3403,6 +3929,7 @@ namespace graphene { namespace net { namespace detail {
                                                const graphene::net::block_message& block_message_to_process, const message_hash_type& message_hash )
     {
       VERIFY_CORRECT_THREAD();
+      TRACE_SPAN( "p2p process_block_during_sync", block_message_to_process.block.block_num() );
       dlog( "received a sync block from peer ${endpoint}", ("endpoint", originating_peer->get_remote_endpoint() ) );
 
       // add it to the front of _received_sync_items, then process _received_sync_items to try to
@@ -3422,6 +3949,7 @@ namespace graphene { namespace net { namespace detail {
       std::string disconnect_reason;
       fc::oexception disconnect_exception;
       fc::oexception restart_sync_exception;
+      bool relayed_before_validation = false;
       try
       {
         // we can get into an intersting situation near the end of synchronization.  We can be in
@@ -3436,6 +3964,8 @@ namespace graphene { namespace net { namespace detail {
         {
           std::vector<fc::uint160_t> contained_transaction_message_ids;
           _message_ids_currently_being_processed.insert(message_hash);
+          if (_cut_through_block_relay)
+            relayed_before_validation = relay_block_before_validation(originating_peer, block_message_to_process, message_receive_time);
           fc_ilog(fc::logger::get("sync"),
                   "p2p pushing block #${block_num} ${block_hash} from ${peer} (message_id was ${id})",
                   ("block_num", block_message_to_process.block.block_num())
@@ -3478,6 +4008,7 @@ namespace graphene { namespace net { namespace detail {
         }
 
         dlog( "this client validated the incoming block, advertising it to other peers" );
+        forget_compact_blocks_in_progress(block_message_to_process.block_id);
 
         item_id block_message_item_id(core_message_type_enum::block_message_type, message_hash);
         uint32_t block_number = block_message_to_process.block.block_num();
@@ -3499,6 +4030,7 @@ namespace graphene { namespace net { namespace detail {
           }
           peer->clear_old_inventory();
         }
+        // peers offered the block before it was applied are skipped by the advertise loop
         message_propagation_data propagation_data{message_receive_time, message_validated_time, originating_peer->node_id};
         broadcast( block_message_to_process, propagation_data );
         _message_cache.block_accepted();
@@ -3539,6 +4071,8 @@ namespace graphene { namespace net { namespace detail {
       catch (const unlinkable_block_exception& e)
       {
         restart_sync_exception = e;
+        if (relayed_before_validation)
+          withdraw_relayed_block(block_message_to_process, message_hash);
       }
       catch (const fc::exception& e)
       {
@@ -3546,6 +4080,18 @@ namespace graphene { namespace net { namespace detail {
         wlog("Failed to push block ${num} (id:${id}), client rejected block sent by peer",
               ("num", block_message_to_process.block.block_num())
               ("id", block_message_to_process.block_id));
+        if (relayed_before_validation)
+          withdraw_relayed_block(block_message_to_process, message_hash);
+        _recently_failed_items.insert(peer_connection::timestamped_item_id(item_id(block_message_type, message_hash), fc::time_point::now()));
+
+        if (originating_peer->core_protocol_version >= GRAPHENE_NET_EARLY_BLOCK_RELAY_PROTOCOL_VERSION &&
+            block_passes_precheck(block_message_to_process))
+        {
+          // the scheduled witness signed it, the peer may have relayed it before applying it the way we do
+          wlog("not disconnecting peer ${endpoint}, the rejected block was signed by its scheduled witness",
+               ("endpoint", originating_peer->get_remote_endpoint()));
+          return;
+        }
 
         disconnect_exception = e;
         disconnect_reason = "You offered me a block that I have deemed to be invalid";
@@ -3571,6 +4117,92 @@ namespace graphene { namespace net { namespace detail {
         disconnect_from_peer(peer.get(), disconnect_reason, true, *disconnect_exception);
       }
     }
+
+    /// Whether the block passes the cheap checks done before relaying it ahead of applying it
+    bool node_impl::block_passes_precheck(const graphene::net::block_message& block_message_to_check)
+    {
+      VERIFY_CORRECT_THREAD();
+      try
+      {
+        _delegate->precheck_block(block_message_to_check);
+        return true;
+      }
+      catch (const fc::canceled_exception&)
+      {
+        throw;
+      }
+      catch (const fc::exception&)
+      {
+        return false;
+      }
+    }
+
+    /**
+     * Cut-through relay: once the cheap checks of the block pass (it builds on our head block, the
+     * scheduled witness signed it, its merkle root matches) it is advertised while the delegate applies it,
+     * instead of after, to the peers whose protocol version tolerates such a block failing to apply.
+     * Returns false if the checks failed, the block is then relayed the usual way if applying it
+     * succeeds.
+     */
+    bool node_impl::relay_block_before_validation(peer_connection* originating_peer,
+                                                  const graphene::net::block_message& block_message_to_relay,
+                                                  const fc::time_point& message_receive_time)
+    {
+      VERIFY_CORRECT_THREAD();
+      try
+      {
+        _delegate->precheck_block(block_message_to_relay);
+      }
+      catch (const fc::canceled_exception&)
+      {
+        throw;
+      }
+      catch (const fc::exception& e)
+      {
+        dlog("not relaying block ${num} before applying it: ${e}",
+             ("num", block_message_to_relay.block.block_num())("e", e.to_string()));
+        return false;
+      }
+
+      // Older peers disconnect anyone offering them a block that fails to apply, they are only
+      // offered the block by the usual broadcast once it has been applied
+      message block_message_to_send(block_message_to_relay);
+      message_hash_type message_hash = block_message_to_send.id();
+      message_propagation_data propagation_data{message_receive_time, fc::time_point::now(), originating_peer->node_id};
+      _message_cache.cache_message(block_message_to_send, message_hash, propagation_data, block_message_to_relay.block_id);
+      _most_recent_blocks_accepted.push_back(block_message_to_relay.block_id);
+
+      item_id block_item(block_message_type, message_hash);
+      for (const peer_connection_ptr& peer : _active_connections)
+      {
+        if (peer->core_protocol_version < GRAPHENE_NET_EARLY_BLOCK_RELAY_PROTOCOL_VERSION ||
+            peer->peer_needs_sync_items_from_us ||
+            peer->inventory_advertised_to_peer.find(block_item) != peer->inventory_advertised_to_peer.end() ||
+            peer->inventory_peer_advertised_to_us.find(block_item) != peer->inventory_peer_advertised_to_us.end())
+          continue;
+        peer->inventory_advertised_to_peer.insert(peer_connection::timestamped_item_id(block_item, fc::time_point::now()));
+        peer->send_message(item_ids_inventory_message(block_message_type, std::vector<item_hash_t>{message_hash}));
+      }
+      return true;
+    }
+
+    /**
+     * A block relayed before validation failed to apply.  Stop offering it, peers that already fetched it
+     * reject it themselves.
+     */
+    void node_impl::withdraw_relayed_block(const graphene::net::block_message& rejected_block, const message_hash_type& message_hash)
+    {
+      VERIFY_CORRECT_THREAD();
+      wlog("withdrawing block ${num} (id:${id}), it was relayed before it failed to apply",
+           ("num", rejected_block.block.block_num())("id", rejected_block.block_id));
+      _message_ids_currently_being_processed.erase(message_hash);
+      _new_inventory.erase(item_id(block_message_type, message_hash));
+      _message_cache.forget_message(message_hash);
+      _most_recent_blocks_accepted.erase(std::remove(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
+                                                     rejected_block.block_id),
+                                         _most_recent_blocks_accepted.end());
+    }
+
     void node_impl::process_block_message(peer_connection* originating_peer,
                                           const message& message_to_process,
                                           const message_hash_type& message_hash)
@@ -3586,6 +4218,7 @@ namespace graphene { namespace net { namespace detail {
       {
 				// if we did request during normal operation
         originating_peer->items_requested_from_peer.erase(item_iter);
+        originating_peer->compact_blocks_in_progress.erase(message_hash);
         process_block_during_normal_operation(originating_peer, block_message_to_process, message_hash);
         if (originating_peer->idle())
           trigger_fetch_items_loop();
@@ -3597,6 +4230,7 @@ namespace graphene { namespace net { namespace detail {
         auto sync_item_iter = originating_peer->sync_items_requested_from_peer.find( block_message_to_process.block_id);
         if (sync_item_iter != originating_peer->sync_items_requested_from_peer.end())
         {
+          fc::time_point request_time = sync_item_iter->second;
           originating_peer->sync_items_requested_from_peer.erase(sync_item_iter);
           // if exceptions are throw here after removing the sync item from the list (above),
           // it could leave our sync in a stalled state.  Wrap a try/catch around the rest
@@ -3604,8 +4238,20 @@ namespace graphene { namespace net { namespace detail {
           try
           {
             originating_peer->last_sync_item_received_time = fc::time_point::now();
+            originating_peer->record_sync_item_received(request_time, _maximum_blocks_per_peer_during_syncing);
             _active_sync_requests.erase(block_message_to_process.block_id);
-            process_block_during_sync(originating_peer, block_message_to_process, message_hash);
+
+            auto reassigned_iter = _reassigned_sync_items.find(block_message_to_process.block_id);
+            if (reassigned_iter != _reassigned_sync_items.end() && reassigned_iter->second)
+              dlog("dropping second copy of sync block ${id} from peer ${endpoint}",
+                   ("id", block_message_to_process.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+            else
+            {
+              if (reassigned_iter != _reassigned_sync_items.end())
+                reassigned_iter->second = true;
+              process_block_during_sync(originating_peer, block_message_to_process, message_hash);
+            }
+
             if (originating_peer->idle())
             {
               // we have finished fetching a batch of items, so we either need to grab another batch of items
@@ -3616,6 +4262,8 @@ namespace graphene { namespace net { namespace detail {
               else
                 trigger_fetch_sync_items_loop();
             }
+            else if (originating_peer->sync_items_requested_from_peer.size() <= originating_peer->sync_window / 2)
+              trigger_fetch_sync_items_loop(); // refill the window before it runs dry
             return;
           }
           catch (const fc::canceled_exception& e)
@@ -3922,9 +4570,22 @@ namespace graphene { namespace net { namespace detail {
       VERIFY_CORRECT_THREAD();
       fc::time_point message_receive_time = fc::time_point::now();
 
-      // only process it if we asked for it
-      auto iter = originating_peer->items_requested_from_peer.find( item_id(message_to_process.msg_type, message_hash) );
-      if( iter == originating_peer->items_requested_from_peer.end() )
+      // only process it if we asked for it, or if it's a transaction from a peer allowed to push them
+      item_id received_item( message_to_process.msg_type, message_hash );
+      auto iter = originating_peer->items_requested_from_peer.find( received_item );
+      if( iter != originating_peer->items_requested_from_peer.end() )
+      {
+        originating_peer->items_requested_from_peer.erase( iter );
+        if (originating_peer->idle())
+          trigger_fetch_items_loop();
+      }
+      else if( message_to_process.msg_type == trx_message_type &&
+               originating_peer->core_protocol_version >= GRAPHENE_NET_TRANSACTION_PUSH_PROTOCOL_VERSION )
+      {
+        if( !accept_pushed_transaction( originating_peer, received_item ) )
+          return;
+      }
+      else
       {
         wlog( "received a message I didn't ask for from peer ${endpoint}, disconnecting from peer",
              ( "endpoint", originating_peer->get_remote_endpoint() ) );
@@ -3933,41 +4594,107 @@ namespace graphene { namespace net { namespace detail {
         disconnect_from_peer( originating_peer, "You sent me a message that I didn't request", true, detailed_error );
         return;
       }
-      else
-      {
-        originating_peer->items_requested_from_peer.erase( iter );
-        if (originating_peer->idle())
-          trigger_fetch_items_loop();
 
-        // Next: have the delegate process the message
-        fc::time_point message_validated_time;
-        try
+      // Next: have the delegate process the message
+      fc::time_point message_validated_time;
+      try
+      {
+        if (message_to_process.msg_type == trx_message_type)
         {
-          if (message_to_process.msg_type == trx_message_type)
+          trx_message transaction_message_to_process = message_to_process.as<trx_message>();
+          dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
+          // a copy pushed by another peer meanwhile is not processed a second time
+          _message_ids_currently_being_processed.insert(message_hash);
+          try
           {
-            trx_message transaction_message_to_process = message_to_process.as<trx_message>();
-            dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
             _delegate->handle_transaction(transaction_message_to_process);
           }
-          else
-            _delegate->handle_message( message_to_process );
-          message_validated_time = fc::time_point::now();
-        }
-        catch ( const fc::canceled_exception& )
-        {
-          throw;
-        }
-        catch ( const fc::exception& e )
-        {
-          wlog( "client rejected message sent by peer ${peer}, ${e}", ("peer", originating_peer->get_remote_endpoint() )("e", e) );
-          // record it so we don't try to fetch this item again
-          _recently_failed_items.insert(peer_connection::timestamped_item_id(item_id(message_to_process.msg_type, message_hash ), fc::time_point::now()));
-          return;
+          catch (...)
+          {
+            _message_ids_currently_being_processed.erase(message_hash);
+            throw;
+          }
+          _message_ids_currently_being_processed.erase(message_hash);
         }
+        else
+          _delegate->handle_message( message_to_process );
+        message_validated_time = fc::time_point::now();
+      }
+      catch ( const fc::canceled_exception& )
+      {
+        throw;
+      }
+      catch ( const fc::exception& e )
+      {
+        wlog( "client rejected message sent by peer ${peer}, ${e}", ("peer", originating_peer->get_remote_endpoint() )("e", e) );
+        // record it so we don't try to fetch this item again
+        _recently_failed_items.insert(peer_connection::timestamped_item_id(received_item, fc::time_point::now()));
+        return;
+      }
 
-        // finally, if the delegate validated the message, broadcast it to our other peers
-        message_propagation_data propagation_data{message_receive_time, message_validated_time, originating_peer->node_id};
-        broadcast( message_to_process, propagation_data );
+      // finally, if the delegate validated the message, broadcast it to our other peers
+      message_propagation_data propagation_data{message_receive_time, message_validated_time, originating_peer->node_id};
+      broadcast( message_to_process, propagation_data );
+    }
+
+    /**
+     * Decides whether a transaction the peer pushed to us without being asked is new and should be
+     * processed.  Either way the peer has it, so it won't be pushed or advertised back.
+     */
+    bool node_impl::accept_pushed_transaction( peer_connection* originating_peer, const item_id& pushed_item )
+    {
+      VERIFY_CORRECT_THREAD();
+      // same flood protection as for advertised transactions
+      if( originating_peer->is_inventory_advertised_to_us_list_full_for_transactions() )
+        return false;
+      originating_peer->inventory_peer_advertised_to_us.insert( peer_connection::timestamped_item_id( pushed_item, fc::time_point::now() ) );
+      ++originating_peer->transactions_pushed_by_peer;
+
+      if( _new_inventory.find( pushed_item ) != _new_inventory.end() ||
+          _recently_failed_items.find( pushed_item ) != _recently_failed_items.end() ||
+          _message_cache.has_message( pushed_item.item_hash ) ||
+          _message_ids_currently_being_processed.find( pushed_item.item_hash ) != _message_ids_currently_being_processed.end() )
+        return false;
+
+      // already on its way from the peer we fetched it from
+      for( const peer_connection_ptr& peer : _active_connections )
+        if( peer->items_requested_from_peer.find( pushed_item ) != peer->items_requested_from_peer.end() )
+          return false;
+
+      // no need to fetch it from whoever advertised it
+      _items_to_fetch.get<item_id_index>().erase( pushed_item );
+      return true;
+    }
+
+    /**
+     * Sends a small transaction in full to the peers that accept pushed transactions and neither have
+     * it nor have been told about it, so it skips the advertise/fetch round trips.  Each peer has a
+     * budget of _transaction_push_bytes_per_second (bursts of up to a second's worth); once that is
+     * spent the peer gets the transaction advertised as usual.
+     */
+    void node_impl::push_transaction_to_peers( const message& trx_message_to_push, const item_id& item )
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::time_point now = fc::time_point::now();
+      for( const peer_connection_ptr& peer : _active_connections )
+      {
+        if( peer->core_protocol_version < GRAPHENE_NET_TRANSACTION_PUSH_PROTOCOL_VERSION ||
+            peer->peer_needs_sync_items_from_us ||
+            peer->inventory_advertised_to_peer.find( item ) != peer->inventory_advertised_to_peer.end() ||
+            peer->inventory_peer_advertised_to_us.find( item ) != peer->inventory_peer_advertised_to_us.end() )
+          continue;
+
+        fc::microseconds elapsed = std::min( now - peer->transaction_push_budget_updated, fc::microseconds( fc::seconds( 1 ) ) );
+        uint64_t refill = uint64_t( elapsed.count() ) * _transaction_push_bytes_per_second / 1000000;
+        peer->transaction_push_budget = std::min<uint64_t>( peer->transaction_push_budget + refill, _transaction_push_bytes_per_second );
+        peer->transaction_push_budget_updated = now;
+        if( peer->transaction_push_budget < trx_message_to_push.size )
+          continue;
+
+        peer->transaction_push_budget -= trx_message_to_push.size;
+        ++peer->transactions_pushed_to_peer;
+        peer->inventory_advertised_to_peer.insert( peer_connection::timestamped_item_id( item, now ) );
+        peer->send_message( trx_message_to_push );
       }
     }
 
@@ -4308,6 +5035,7 @@ namespace graphene { namespace net { namespace detail {
       while ( !_accept_loop_complete.canceled() )
       {
         peer_connection_ptr new_peer(peer_connection::make_shared(this));
+        assign_connection_worker_thread(new_peer);
 
         try
         {
@@ -4730,6 +5458,7 @@ namespace graphene { namespace net { namespace detail {
 
       dlog("node_impl::connect_to_endpoint(${endpoint})", ("endpoint", remote_endpoint));
       peer_connection_ptr new_peer(peer_connection::make_shared(this));
+      assign_connection_worker_thread(new_peer);
       new_peer->set_remote_endpoint(remote_endpoint);
       initiate_connect_to(new_peer);
     }
@@ -4825,6 +5554,7 @@ namespace graphene { namespace net { namespace detail {
       ilog( "node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size() ) );
       ilog( "node._new_inventory size: ${size}", ("size", _new_inventory.size() ) );
       ilog( "node._message_cache size: ${size}", ("size", _message_cache.size() ) );
+      ilog( "node._message_cache statistics: ${statistics}", ("statistics", _message_cache.get_statistics() ) );
       for( const peer_connection_ptr& peer : _active_connections )
       {
         ilog( "  peer ${endpoint}", ("endpoint", peer->get_remote_endpoint() ) );
@@ -4984,6 +5714,22 @@ namespace graphene { namespace net { namespace detail {
         peer_details["current_head_block_number"] = _delegate->get_block_number(peer->last_block_delegate_has_seen);
         peer_details["current_head_block_time"] = peer->last_block_time_delegate_has_seen;
 
+        peer_details["transactions_pushed_to_peer"] = peer->transactions_pushed_to_peer;
+        peer_details["transactions_pushed_by_peer"] = peer->transactions_pushed_by_peer;
+
+        if (peer->we_need_sync_items_from_peer || peer->sync_items_received)
+        {
+          fc::mutable_variant_object sync_status;
+          sync_status["window"] = peer->sync_window;
+          sync_status["in_flight"] = (uint32_t)peer->sync_items_requested_from_peer.size();
+          sync_status["blocks_received"] = peer->sync_items_received;
+          sync_status["blocks_per_second"] = peer->get_sync_items_per_second();
+          sync_status["latency_ms"] = peer->sync_latency.count() / 1000;
+          sync_status["min_latency_ms"] = peer->sync_min_latency.count() / 1000;
+          sync_status["requests_reassigned"] = peer->sync_requests_reassigned;
+          peer_details["sync_status"] = sync_status;
+        }
+
         this_peer_status.info = peer_details;
         statuses.push_back(this_peer_status);
       }
@@ -5015,6 +5761,9 @@ namespace graphene { namespace net { namespace detail {
       message_hash_type hash_of_item_to_broadcast = item_to_broadcast.id();
 
       _message_cache.cache_message( item_to_broadcast, hash_of_item_to_broadcast, propagation_data, hash_of_message_contents );
+      if( item_to_broadcast.msg_type == graphene::net::trx_message_type &&
+          item_to_broadcast.size <= _transaction_push_max_size )
+        push_transaction_to_peers( item_to_broadcast, item_id(item_to_broadcast.msg_type, hash_of_item_to_broadcast) );
       _new_inventory.insert( item_id(item_to_broadcast.msg_type, hash_of_item_to_broadcast ) );
       trigger_advertise_inventory_loop();
     }
@@ -5067,6 +5816,16 @@ namespace graphene { namespace net { namespace detail {
         _maximum_number_of_sync_blocks_to_prefetch = params["maximum_number_of_sync_blocks_to_prefetch"].as<uint32_t>();
       if (params.contains("maximum_blocks_per_peer_during_syncing"))
         _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>();
+      if (params.contains("connection_worker_threads"))
+        set_connection_worker_threads(params["connection_worker_threads"].as<uint32_t>());
+      if (params.contains("message_cache_max_bytes"))
+        _message_cache.set_max_bytes(params["message_cache_max_bytes"].as<uint64_t>());
+      if (params.contains("cut_through_block_relay"))
+        _cut_through_block_relay = params["cut_through_block_relay"].as<bool>();
+      if (params.contains("transaction_push_max_size"))
+        _transaction_push_max_size = params["transaction_push_max_size"].as<uint32_t>();
+      if (params.contains("transaction_push_bytes_per_second"))
+        _transaction_push_bytes_per_second = params["transaction_push_bytes_per_second"].as<uint32_t>();
 
       _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -5086,9 +5845,38 @@ namespace graphene { namespace net { namespace detail {
       result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
       result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
       result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+      result["connection_worker_threads"] = _connection_worker_thread_count;
+      result["message_cache_max_bytes"] = _message_cache.max_bytes();
+      result["cut_through_block_relay"] = _cut_through_block_relay;
+      result["transaction_push_max_size"] = _transaction_push_max_size;
+      result["transaction_push_bytes_per_second"] = _transaction_push_bytes_per_second;
       return result;
     }
 
+    /**
+     * Connections that already have a worker keep it, the old threads shut down once the last of
+     * those connections is gone.  Zero threads does all the crypto on the p2p thread again.
+     */
+    void node_impl::set_connection_worker_threads(uint32_t num_threads)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (num_threads == _connection_worker_thread_count)
+        return;
+      _connection_worker_thread_count = num_threads;
+      _connection_worker_threads.clear();
+    }
+
+    void node_impl::assign_connection_worker_thread(const peer_connection_ptr& peer)
+    {
+      VERIFY_CORRECT_THREAD();
+      if (_connection_worker_thread_count == 0)
+        return;
+      if (_connection_worker_threads.empty())
+        for (uint32_t i = 0; i < _connection_worker_thread_count; ++i)
+          _connection_worker_threads.push_back(std::make_shared<fc::thread>("p2p_worker_" + std::to_string(i)));
+      peer->set_worker_thread(_connection_worker_threads[_next_connection_worker++ % _connection_worker_threads.size()]);
+    }
+
     message_propagation_data node_impl::get_transaction_propagation_data( const graphene::net::transaction_id_type& transaction_id )
     {
       VERIFY_CORRECT_THREAD();
@@ -5154,6 +5942,7 @@ namespace graphene { namespace net { namespace detail {
       info["node_public_key"] = _node_public_key;
       info["node_id"] = _node_id;
       info["firewalled"] = _is_firewalled;
+      info["message_cache"] = _message_cache.get_statistics();
       return info;
     }
     fc::variant_object node_impl::network_get_usage_stats() const
@@ -5180,10 +5969,28 @@ namespace graphene { namespace net { namespace detail {
                      std::back_inserter(network_usage_by_hour),
                      std::plus<uint32_t>());
 
+      // ratios are compressed / uncompressed payload size of the messages that were compressed
+      auto compression_ratio = [](uint64_t compressed, uint64_t uncompressed) {
+        return uncompressed ? double(compressed) / double(uncompressed) : 1.0;
+      };
+      std::vector<fc::variant_object> compression_by_peer;
+      for (const peer_connection_ptr& peer : _active_connections)
+      {
+        message_compression_stats stats = peer->get_compression_stats();
+        fc::mutable_variant_object peer_stats;
+        peer_stats["peer"] = peer->get_remote_endpoint();
+        peer_stats["bytes"] = stats;
+        peer_stats["send_ratio"] = compression_ratio(stats.compressed_bytes_sent, stats.uncompressed_bytes_sent);
+        peer_stats["receive_ratio"] = compression_ratio(stats.compressed_bytes_received, stats.uncompressed_bytes_received);
+        compression_by_peer.push_back(peer_stats);
+      }
+
       fc::mutable_variant_object result;
       result["usage_by_second"] = network_usage_by_second;
       result["usage_by_minute"] = network_usage_by_minute;
       result["usage_by_hour"] = network_usage_by_hour;
+      result["compression_by_peer"] = compression_by_peer;
+      result["receive_buffers"] = message_buffer_pool::instance().get_stats();
       return result;
     }
 
@@ -5549,6 +6356,16 @@ namespace graphene { namespace net { namespace detail {
       INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_message_ids);
     }
 
+    void statistics_gathering_node_delegate_wrapper::precheck_block( const graphene::net::block_message& block_message )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(precheck_block, block_message);
+    }
+
+    void statistics_gathering_node_delegate_wrapper::handle_blocks( const std::vector<graphene::net::block_message>& block_messages, std::vector<fc::exception_ptr>& results )
+    {
+      INVOKE_AND_COLLECT_STATISTICS(handle_blocks, block_messages, results);
+    }
+
     void statistics_gathering_node_delegate_wrapper::handle_transaction( const graphene::net::trx_message& transaction_message )
     {
       INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
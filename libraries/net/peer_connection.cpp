@@ -415,6 +415,67 @@ namespace graphene { namespace net
       return _message_connection.get_total_bytes_received();
     }
 
+    void peer_connection::enable_compression(uint32_t min_message_size)
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.enable_compression(min_message_size);
+    }
+
+    message_compression_stats peer_connection::get_compression_stats() const
+    {
+      VERIFY_CORRECT_THREAD();
+      return _message_connection.get_compression_stats();
+    }
+
+    void peer_connection::set_worker_thread(const std::shared_ptr<fc::thread>& worker_thread)
+    {
+      VERIFY_CORRECT_THREAD();
+      _message_connection.set_worker_thread(worker_thread);
+    }
+
+    void peer_connection::record_sync_item_received(const fc::time_point& request_time, uint32_t maximum_window)
+    {
+      VERIFY_CORRECT_THREAD();
+      fc::time_point now = fc::time_point::now();
+      fc::microseconds latency = now - request_time;
+      // don't count the time we had nothing requested from the peer
+      fc::microseconds interval = now - std::max(last_sync_item_arrival_time, request_time);
+      last_sync_item_arrival_time = now;
+
+      if (sync_items_received++ == 0)
+      {
+        sync_latency = latency;
+        sync_min_latency = latency;
+        sync_item_interval = interval;
+      }
+      else
+      {
+        sync_latency = fc::microseconds((sync_latency.count() * 7 + latency.count()) / 8);
+        sync_min_latency = std::min(sync_min_latency, latency);
+        sync_item_interval = fc::microseconds((sync_item_interval.count() * 7 + interval.count()) / 8);
+      }
+
+      // as long as our requests aren't queueing up at the peer, one more in flight for every block
+      // received, which doubles the window every round trip
+      if (latency.count() <= 2 * sync_min_latency.count() && sync_window < maximum_window)
+        ++sync_window;
+    }
+
+    void peer_connection::record_sync_request_stalled(uint32_t requests_reassigned)
+    {
+      VERIFY_CORRECT_THREAD();
+      sync_requests_reassigned += requests_reassigned;
+      sync_window = std::max<uint32_t>(sync_window / 2, GRAPHENE_NET_MIN_SYNC_WINDOW);
+    }
+
+    double peer_connection::get_sync_items_per_second() const
+    {
+      VERIFY_CORRECT_THREAD();
+      if (sync_item_interval.count() <= 0)
+        return 0;
+      return 1000000.0 / sync_item_interval.count();
+    }
+
     fc::time_point peer_connection::get_last_message_sent_time() const
     {
       VERIFY_CORRECT_THREAD();
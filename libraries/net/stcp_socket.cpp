@@ -163,6 +163,19 @@ size_t stcp_socket::writesome( const std::shared_ptr<const char>& buf, size_t le
   return writesome(buf.get() + offset, len);
 }
 
+void stcp_socket::encrypt( const char* plaintext, size_t len, char* ciphertext )
+{
+  assert( (len % 16) == 0 );
+  uint32_t ciphertext_len = _send_aes.encode( plaintext, len, ciphertext );
+  FC_ASSERT( ciphertext_len == len, "", ("ciphertext_len",ciphertext_len)("len",len) );
+}
+
+void stcp_socket::decrypt( const char* ciphertext, size_t len, char* plaintext )
+{
+  assert( (len % 16) == 0 );
+  _recv_aes.decode( ciphertext, len, plaintext );
+}
+
 void stcp_socket::flush()
 {
   _sock.flush();
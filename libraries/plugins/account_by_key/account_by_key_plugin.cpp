@@ -256,8 +256,23 @@ void account_by_key_plugin::plugin_initialize( const boost::program_options::var
       ilog( "Initializing account_by_key plugin" );
       chain::database& db = database();
 
-      db.pre_apply_operation.connect( [&]( const operation_notification& o ){ my->pre_operation( o ); } );
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ my->post_operation( o ); } );
+      db.subscribe_pre_apply_operation( chain::database::operation_tags<
+            protocol::accountCreate_operation,
+            protocol::accountCreateWithDelegation_operation,
+            protocol::accountUpdate_operation,
+            protocol::recover_account_operation,
+            protocol::pow_operation,
+            protocol::pow2_operation >(),
+         [&]( const operation_notification& o ){ my->pre_operation( o ); } );
+      db.subscribe_post_apply_operation( chain::database::operation_tags<
+            protocol::accountCreate_operation,
+            protocol::accountCreateWithDelegation_operation,
+            protocol::accountUpdate_operation,
+            protocol::recover_account_operation,
+            protocol::pow_operation,
+            protocol::pow2_operation,
+            protocol::hardfork_operation >(),
+         [&]( const operation_notification& o ){ my->post_operation( o ); } );
 
       add_plugin_index< key_lookup_index >(db);
    }
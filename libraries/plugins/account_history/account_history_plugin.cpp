@@ -123,11 +123,10 @@ struct operation_visitor_filter : operation_visitor
 
 void account_history_plugin_impl::on_operation( const operation_notification& note )
 {
-   flat_set<account_name_type> impacted;
    node::chain::database& db = database();
 
    const operation_object* new_obj = nullptr;
-   app::operation_get_impacted_accounts( note.op, impacted );
+   const auto& impacted = app::operation_get_impacted_accounts( note );
 
    for( const auto& item : impacted ) {
       auto itr = _tracked_accounts.lower_bound( item );
@@ -204,7 +203,7 @@ void account_history_plugin::plugin_set_program_options(
 void account_history_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    //ilog("Intializing account history plugin" );
-   database().pre_apply_operation.connect( [&]( const operation_notification& note ){ my->on_operation(note); } );
+   database().deferred_apply_operation.connect( [&]( const operation_notification& note ){ my->on_operation(note); } );
 
    typedef pair<account_name_type,account_name_type> pairstring;
    LOAD_VALUE_SET(options, "track-account-range", my->_tracked_accounts, pairstring);
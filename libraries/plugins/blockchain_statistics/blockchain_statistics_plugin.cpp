@@ -429,7 +429,10 @@ void blockchain_statistics_plugin::plugin_initialize( const boost::program_optio
       chain::database& db = database();
 
       db.applied_block.connect( [&]( const signed_block& b ){ _my->on_block( b ); } );
-      db.pre_apply_operation.connect( [&]( const operation_notification& o ){ _my->pre_operation( o ); } );
+      db.subscribe_pre_apply_operation( chain::database::operation_tags<
+            protocol::deleteComment_operation,
+            protocol::withdrawSCORE_operation >(),
+         [&]( const operation_notification& o ){ _my->pre_operation( o ); } );
       db.post_apply_operation.connect( [&]( const operation_notification& o ){ _my->post_operation( o ); } );
 
       add_plugin_index< bucket_index >(db);
@@ -361,8 +361,15 @@ void follow_plugin::plugin_initialize( const boost::program_options::variables_m
       chain::database& db = database();
       my->plugin_initialize();
 
-      db.pre_apply_operation.connect( [&]( const operation_notification& o ){ my->pre_operation( o ); } );
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ my->post_operation( o ); } );
+      db.subscribe_pre_apply_operation( chain::database::operation_tags<
+            protocol::vote_operation,
+            protocol::deleteComment_operation >(),
+         [&]( const operation_notification& o ){ my->pre_operation( o ); } );
+      db.subscribe_post_apply_operation( chain::database::operation_tags<
+            protocol::customJson_operation,
+            protocol::comment_operation,
+            protocol::vote_operation >(),
+         [&]( const operation_notification& o ){ my->post_operation( o ); } );
       add_plugin_index< follow_index       >(db);
       add_plugin_index< feed_index         >(db);
       add_plugin_index< blog_index         >(db);
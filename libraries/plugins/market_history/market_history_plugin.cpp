@@ -177,7 +177,8 @@ void market_history_plugin::plugin_initialize( const boost::program_options::var
       ilog( "market_history: plugin_initialize() begin" );
       chain::database& db = database();
 
-      db.post_apply_operation.connect( [&]( const operation_notification& o ){ _my->update_market_histories( o ); } );
+      db.subscribe_deferred_apply_operation( chain::database::operation_tags< protocol::fill_order_operation >(),
+         [&]( const operation_notification& o ){ _my->update_market_histories( o ); } );
       add_plugin_index< bucket_index        >(db);
       add_plugin_index< order_history_index >(db);
 
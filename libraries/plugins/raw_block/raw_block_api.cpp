@@ -39,17 +39,17 @@ get_raw_block_result raw_block_api::get_raw_block( get_raw_block_args args )
    get_raw_block_result result;
    std::shared_ptr< node::chain::database > db = my->app.chain_database();
 
-   fc::optional<chain::signed_block> block = db->fetch_block_by_number( args.block_num );
-   if( !block.valid() )
+   fc::optional< std::vector<char> > serialized_block = db->fetch_block_bytes_by_number( args.block_num );
+   if( !serialized_block.valid() )
    {
       return result;
    }
-   std::vector<char> serialized_block = fc::raw::pack( *block );
+   protocol::signed_block_view block( *serialized_block );
    result.raw_block = fc::base64_encode( std::string(
-      &serialized_block[0], &serialized_block[0] + serialized_block.size()) );
-   result.block_id = block->id();
-   result.previous = block->previous;
-   result.timestamp = block->timestamp;
+      serialized_block->data(), serialized_block->data() + serialized_block->size()) );
+   result.block_id = block.id();
+   result.previous = block.header().previous;
+   result.timestamp = block.header().timestamp;
    return result;
 }
 
@@ -523,7 +523,14 @@ void tags_plugin::plugin_set_program_options(
 void tags_plugin::plugin_initialize(const boost::program_options::variables_map& options)
 {
    ilog("Intializing tags plugin" );
-   database().post_apply_operation.connect( [&]( const operation_notification& note){ my->on_operation(note); } );
+   database().subscribe_post_apply_operation( chain::database::operation_tags<
+         protocol::comment_operation,
+         protocol::transfer_operation,
+         protocol::vote_operation,
+         protocol::deleteComment_operation,
+         protocol::comment_reward_operation,
+         protocol::comment_payout_update_operation >(),
+      [&]( const operation_notification& note){ my->on_operation(note); } );
 
    app().register_api_factory<tag_api>("tag_api");
 }
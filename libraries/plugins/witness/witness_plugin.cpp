@@ -327,10 +327,7 @@ namespace detail
          case operation::tag< customJson_operation >::value:
          case operation::tag< custom_binary_operation >::value:
          {
-            flat_set< account_name_type > impacted;
-            app::operation_get_impacted_accounts( note.op, impacted );
-
-            for( auto& account : impacted )
+            for( auto& account : app::operation_get_impacted_accounts( note ) )
                if( db.is_producing() )
                   ASSERT( _dupe_customs.insert( account ).second, plugin_exception,
                      "Account ${a} already submitted a custom json operation this block.",
@@ -559,10 +556,20 @@ void witness_plugin::plugin_initialize(const boost::program_options::variables_m
 
    chain::database& db = database();
 
-   db.post_apply_operation.connect( [&]( const operation_notification& note ){ _my->post_operation( note ); } );
+   db.subscribe_post_apply_operation( chain::database::operation_tags<
+         protocol::custom_operation,
+         protocol::customJson_operation,
+         protocol::custom_binary_operation >(),
+      [&]( const operation_notification& note ){ _my->post_operation( note ); } );
    db.pre_apply_block.connect( [&]( const signed_block& b ){ _my->pre_apply_block( b ); } );
    db.on_pre_apply_transaction.connect( [&]( const signed_transaction& tx ){ _my->pre_transaction( tx ); } );
-   db.pre_apply_operation.connect( [&]( const operation_notification& note ){ _my->pre_operation( note ); } );
+   db.subscribe_pre_apply_operation( chain::database::operation_tags<
+         protocol::comment_options_operation,
+         protocol::comment_operation,
+         protocol::transfer_operation,
+         protocol::transferToSavings_operation,
+         protocol::transferFromSavings_operation >(),
+      [&]( const operation_notification& note ){ _my->pre_operation( note ); } );
    db.applied_block.connect( [&]( const signed_block& b ){ _my->on_block( b ); } );
 
    add_plugin_index< account_bandwidth_index >( db );
@@ -0,0 +1,99 @@
+#include <node/protocol/block_view.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace node { namespace protocol {
+
+   signed_block_view::signed_block_view( const char* data, size_t size )
+      : _data( data ), _size( size )
+   {
+      fc::datastream< const char* > ds( _data, _size );
+      fc::raw::unpack( ds, _header );
+
+      fc::unsigned_int count;
+      fc::raw::unpack( ds, count );
+      _transaction_count = count.value;
+
+      _transaction_offsets.reserve( _transaction_count + 1 );
+      _transaction_offsets.push_back( ds.tellp() );
+   }
+
+   signed_block_view::signed_block_view( const vector< char >& packed )
+      : signed_block_view( packed.data(), packed.size() ) {}
+
+   void signed_block_view::find_transaction_end( uint32_t i )const
+   {
+      FC_ASSERT( i < _transaction_count, "Transaction index out of range", ("i", i)("count", _transaction_count) );
+
+      while( _transaction_offsets.size() <= i + 1 )
+      {
+         size_t begin = _transaction_offsets.back();
+         fc::datastream< const char* > ds( _data + begin, _size - begin );
+         signed_transaction skipped;
+         fc::raw::unpack( ds, skipped );
+         _transaction_offsets.push_back( begin + ds.tellp() );
+      }
+   }
+
+   std::pair< const char*, size_t > signed_block_view::transaction_data( uint32_t i )const
+   {
+      find_transaction_end( i );
+      return std::make_pair( _data + _transaction_offsets[i], _transaction_offsets[i+1] - _transaction_offsets[i] );
+   }
+
+   signed_transaction signed_block_view::transaction( uint32_t i )const
+   {
+      auto trx_data = transaction_data( i );
+      fc::datastream< const char* > ds( trx_data.first, trx_data.second );
+      signed_transaction result;
+      fc::raw::unpack( ds, result );
+      return result;
+   }
+
+   /// Moves ds from the start of a packed transaction to its operation count
+   static void skip_to_operations( fc::datastream< const char* >& ds )
+   {
+      uint16_t           ref_block_num;
+      uint32_t           ref_block_prefix;
+      fc::time_point_sec expiration;
+      fc::raw::unpack( ds, ref_block_num );
+      fc::raw::unpack( ds, ref_block_prefix );
+      fc::raw::unpack( ds, expiration );
+   }
+
+   uint32_t signed_block_view::operation_count( uint32_t i )const
+   {
+      auto trx_data = transaction_data( i );
+      fc::datastream< const char* > ds( trx_data.first, trx_data.second );
+      skip_to_operations( ds );
+
+      fc::unsigned_int count;
+      fc::raw::unpack( ds, count );
+      return count.value;
+   }
+
+   operation signed_block_view::operation_at( uint32_t i, uint32_t op )const
+   {
+      auto trx_data = transaction_data( i );
+      fc::datastream< const char* > ds( trx_data.first, trx_data.second );
+      skip_to_operations( ds );
+
+      fc::unsigned_int count;
+      fc::raw::unpack( ds, count );
+      FC_ASSERT( op < count.value, "Operation index out of range", ("op", op)("count", count.value) );
+
+      operation result;
+      for( uint32_t j = 0; j <= op; ++j )
+         fc::raw::unpack( ds, result );
+      return result;
+   }
+
+   signed_block signed_block_view::unpack()const
+   {
+      fc::datastream< const char* > ds( _data, _size );
+      signed_block result;
+      fc::raw::unpack( ds, result );
+      return result;
+   }
+
+} } // node::protocol
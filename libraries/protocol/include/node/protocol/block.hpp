@@ -7,6 +7,10 @@ namespace node { namespace protocol {
    struct signed_block : public signed_block_header
    {
       checksum_type calculate_merkle_root()const;
+
+      /// Merkle root over the given merkle_digest() of each transaction, in block order
+      static checksum_type calculate_merkle_root( vector< digest_type > ids );
+
       vector<signed_transaction> transactions;
    };
 
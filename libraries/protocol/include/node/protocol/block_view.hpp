@@ -0,0 +1,55 @@
+#pragma once
+#include <node/protocol/block.hpp>
+
+namespace node { namespace protocol {
+
+   /**
+    *  Read-only view over a packed signed_block. Only the header is decoded up front, everything
+    *  else stays in the packed bytes until asked for, so blocks that are only checked and passed
+    *  on (served to peers, written to the block log) never get a full signed_block.
+    *
+    *  Transactions and operations carry no length prefix in the packed format. Their boundaries
+    *  are found by decoding the items in front of them, and are cached, so a transaction is decoded
+    *  at most once to locate the ones after it.
+    *
+    *  The view does not copy the bytes, they must stay valid and unchanged while it is in use.
+    */
+   class signed_block_view
+   {
+      public:
+         signed_block_view( const char* data, size_t size );
+         explicit signed_block_view( const vector< char >& packed );
+
+         const signed_block_header&  header()const    { return _header; }
+         block_id_type               id()const        { return _header.id(); }
+         uint32_t                    block_num()const { return _header.block_num(); }
+
+         const char*                 data()const      { return _data; }
+         size_t                      size()const      { return _size; }
+
+         uint32_t                    transaction_count()const { return _transaction_count; }
+
+         /// Packed bytes of transaction i
+         std::pair< const char*, size_t > transaction_data( uint32_t i )const;
+         signed_transaction          transaction( uint32_t i )const;
+
+         uint32_t                    operation_count( uint32_t i )const;
+         /// Decodes operation op of transaction i, the operations in front of it are skipped over
+         operation                   operation_at( uint32_t i, uint32_t op )const;
+
+         signed_block                unpack()const;
+
+      private:
+         /// Makes sure _transaction_offsets holds the start of transaction i + 1
+         void                        find_transaction_end( uint32_t i )const;
+
+         const char*                 _data = nullptr;
+         size_t                      _size = 0;
+         signed_block_header         _header;
+         uint32_t                    _transaction_count = 0;
+
+         /// Start offsets of the transactions located so far, one more than the transactions decoded
+         mutable vector< size_t >    _transaction_offsets;
+   };
+
+} } // node::protocol
@@ -0,0 +1,54 @@
+#pragma once
+#include <node/protocol/transaction.hpp>
+
+#include <memory>
+
+namespace node { namespace protocol {
+
+   /**
+    *  A signed_transaction together with the values derived from it that every stage of the node
+    *  needs. The transaction is packed once on construction, and its id, digest, merkle digest and
+    *  packed size all come from those bytes. The signing keys are recovered on first request and
+    *  cached.
+    *
+    *  The wrapped transaction must not change after it has been prepared. Recovering the keys is
+    *  not synchronized, so call signature_keys() before handing the object to another thread.
+    */
+   class prepared_transaction
+   {
+      public:
+         explicit prepared_transaction( signed_transaction trx );
+         explicit prepared_transaction( std::shared_ptr< const signed_transaction > trx );
+
+         /// Prepares trx without copying it, trx must outlive the result and all of its copies
+         static prepared_transaction borrow( const signed_transaction& trx );
+
+         const signed_transaction&  get()const        { return *_trx; }
+         const signed_transaction&  operator*()const  { return *_trx; }
+         const signed_transaction*  operator->()const { return _trx.get(); }
+
+         const transaction_id_type& id()const         { return _id; }
+         const digest_type&         digest()const     { return _digest; }
+         const vector< char >&      packed()const     { return _packed; }
+         size_t                     pack_size()const  { return _packed.size(); }
+
+         digest_type                sig_digest( const chain_id_type& chain_id )const;
+         digest_type                merkle_digest()const;
+
+         /// Same result as signed_transaction::get_signature_keys()
+         const flat_set< public_key_type >& signature_keys( const chain_id_type& chain_id )const;
+
+      private:
+         void prepare();
+
+         std::shared_ptr< const signed_transaction >        _trx;
+         vector< char >                                     _packed;
+         size_t                                             _transaction_size = 0; ///< unsigned part at the front of _packed
+         digest_type                                        _digest;
+         transaction_id_type                                _id;
+
+         mutable optional< flat_set< public_key_type > >    _signature_keys;
+         mutable chain_id_type                              _signature_keys_chain_id;
+   };
+
+} } // node::protocol
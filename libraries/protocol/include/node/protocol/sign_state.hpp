@@ -5,7 +5,11 @@
 
 namespace node { namespace protocol {
 
-typedef std::function<authority(const string&)> authority_getter;
+/**
+ *  Returns the authority of an account. The reference must stay valid until the check using the
+ *  getter returns, a getter must not return a reference to a temporary.
+ */
+typedef std::function<const authority&(const string&)> authority_getter;
 
 struct sign_state
 {
@@ -0,0 +1,77 @@
+#include <node/protocol/prepared_transaction.hpp>
+#include <node/protocol/exceptions.hpp>
+
+#include <fc/io/raw.hpp>
+
+namespace node { namespace protocol {
+
+prepared_transaction::prepared_transaction( signed_transaction trx )
+   : _trx( std::make_shared< const signed_transaction >( std::move( trx ) ) )
+{
+   prepare();
+}
+
+prepared_transaction::prepared_transaction( std::shared_ptr< const signed_transaction > trx )
+   : _trx( std::move( trx ) )
+{
+   FC_ASSERT( _trx );
+   prepare();
+}
+
+prepared_transaction prepared_transaction::borrow( const signed_transaction& trx )
+{
+   // aliasing constructor with an empty owner, the caller keeps trx alive
+   return prepared_transaction( std::shared_ptr< const signed_transaction >( std::shared_ptr< const signed_transaction >(), &trx ) );
+}
+
+void prepared_transaction::prepare()
+{
+   // A signed_transaction packs as the unsigned transaction followed by the signatures, so the
+   // digest (and the id) can be taken over a prefix of the packed bytes.
+   const transaction& unsigned_trx = *_trx;
+   _transaction_size = fc::raw::pack_size( unsigned_trx );
+   _packed.resize( _transaction_size + fc::raw::pack_size( _trx->signatures ) );
+
+   fc::datastream< char* > ds( _packed.data(), _packed.size() );
+   fc::raw::pack( ds, unsigned_trx );
+   fc::raw::pack( ds, _trx->signatures );
+
+   _digest = digest_type::hash( _packed.data(), _transaction_size );
+   memcpy( _id._hash, _digest._hash, std::min( sizeof( _id ), sizeof( _digest ) ) );
+}
+
+digest_type prepared_transaction::sig_digest( const chain_id_type& chain_id )const
+{
+   digest_type::encoder enc;
+   fc::raw::pack( enc, chain_id );
+   enc.write( _packed.data(), _transaction_size );
+   return enc.result();
+}
+
+digest_type prepared_transaction::merkle_digest()const
+{
+   return digest_type::hash( _packed.data(), _packed.size() );
+}
+
+const flat_set< public_key_type >& prepared_transaction::signature_keys( const chain_id_type& chain_id )const
+{ try {
+   if( !_signature_keys.valid() || _signature_keys_chain_id != chain_id )
+   {
+      auto d = sig_digest( chain_id );
+      flat_set< public_key_type > result;
+      for( const auto& sig : _trx->signatures )
+      {
+         ASSERT(
+            result.insert( fc::ecc::public_key( sig, d ) ).second,
+            tx_duplicate_sig,
+            "Duplicate Signature detected" );
+      }
+
+      _signature_keys = std::move( result );
+      _signature_keys_chain_id = chain_id;
+   }
+
+   return *_signature_keys;
+} FC_CAPTURE_AND_RETHROW() }
+
+} } // node::protocol
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+#include <fc/variant.hpp>
+
+#include <boost/preprocessor/cat.hpp>
+
+#include <atomic>
+#include <memory>
+
+namespace graphene { namespace utilities {
+
+/**
+ *  Records timed spans from the hot paths of the node into a fixed size ring buffer, to be dumped
+ *  in the Chrome trace event format (chrome://tracing, ui.perfetto.dev).
+ *
+ *  Recording never blocks and never allocates: a writer claims a slot with a single atomic increment
+ *  and publishes it with a sequence number, so spans can be recorded from any thread. Once the
+ *  buffer wraps the oldest spans are overwritten. Readers skip slots that are being rewritten while
+ *  they copy them.
+ *
+ *  The tracer is disabled by default, in which case a TRACE_SPAN costs one relaxed atomic load.
+ */
+class tracer
+{
+   public:
+      static tracer& instance();
+
+      /**
+       *  Starts recording. The buffer is allocated by the first call, which has to happen before
+       *  spans are recorded from other threads; later calls only switch recording back on.
+       */
+      void enable( uint32_t capacity );
+      void disable();
+
+      bool enabled()const { return _enabled.load( std::memory_order_relaxed ); }
+
+      /// @param name must point to a string with static storage duration
+      void record( const char* name, const fc::time_point& begin, const fc::time_point& end, int64_t arg = -1 );
+
+      /// The recorded spans as a Chrome trace object, oldest first
+      fc::variant to_chrome_trace()const;
+      void        write_chrome_trace( const fc::path& file )const;
+
+   private:
+      tracer() {}
+
+      struct slot
+      {
+         /// 2*n+1 while span n is being written, 2*n+2 once it is complete, 0 if never written
+         std::atomic< uint64_t >       seq{ 0 };
+         std::atomic< const char* >    name{ nullptr };
+         std::atomic< int64_t >        begin{ 0 };
+         std::atomic< int64_t >        duration{ 0 };
+         std::atomic< int64_t >        arg{ -1 };
+         std::atomic< uint32_t >       thread_id{ 0 };
+      };
+
+      std::atomic< bool >                 _enabled{ false };
+      std::atomic< uint64_t >             _next{ 0 };
+      std::unique_ptr< slot[] >           _slots;
+      uint32_t                            _capacity = 0;
+};
+
+/**
+ *  Records the lifetime of the enclosing scope as a span. The optional argument (e.g. a block
+ *  number) is shown with the span in the trace viewer.
+ */
+class trace_span
+{
+   public:
+      trace_span( const char* name, int64_t arg = -1 )
+      {
+         if( tracer::instance().enabled() )
+         {
+            _name = name;
+            _arg = arg;
+            _begin = fc::time_point::now();
+         }
+      }
+
+      ~trace_span()
+      {
+         if( _name != nullptr )
+            tracer::instance().record( _name, _begin, fc::time_point::now(), _arg );
+      }
+
+   private:
+      const char*       _name = nullptr;
+      int64_t           _arg = -1;
+      fc::time_point    _begin;
+};
+
+} } // graphene::utilities
+
+#define TRACE_SPAN( ... ) \
+   graphene::utilities::trace_span BOOST_PP_CAT( _trace_span_, __LINE__ )( __VA_ARGS__ )
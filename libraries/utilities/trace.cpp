@@ -0,0 +1,112 @@
+#include <graphene/utilities/trace.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+namespace graphene { namespace utilities {
+
+namespace {
+
+/// Small sequential ids read better in the trace viewer than native thread handles
+uint32_t current_thread_id()
+{
+   static std::atomic< uint32_t > next_id{ 0 };
+   thread_local uint32_t id = ++next_id;
+   return id;
+}
+
+} // anonymous
+
+tracer& tracer::instance()
+{
+   static tracer the_tracer;
+   return the_tracer;
+}
+
+void tracer::enable( uint32_t capacity )
+{
+   FC_ASSERT( capacity > 0, "Trace buffer needs at least one slot" );
+   if( !_slots )
+   {
+      _slots.reset( new slot[ capacity ] );
+      _capacity = capacity;
+   }
+   _enabled.store( true, std::memory_order_relaxed );
+}
+
+void tracer::disable()
+{
+   _enabled.store( false, std::memory_order_relaxed );
+}
+
+void tracer::record( const char* name, const fc::time_point& begin, const fc::time_point& end, int64_t arg )
+{
+   if( !_slots )
+      return;
+
+   uint64_t n = _next.fetch_add( 1, std::memory_order_relaxed );
+   slot& s = _slots[ n % _capacity ];
+
+   s.seq.store( 2 * n + 1, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_release );
+
+   s.name.store( name, std::memory_order_relaxed );
+   s.begin.store( begin.time_since_epoch().count(), std::memory_order_relaxed );
+   s.duration.store( ( end - begin ).count(), std::memory_order_relaxed );
+   s.arg.store( arg, std::memory_order_relaxed );
+   s.thread_id.store( current_thread_id(), std::memory_order_relaxed );
+
+   s.seq.store( 2 * n + 2, std::memory_order_release );
+}
+
+fc::variant tracer::to_chrome_trace()const
+{
+   fc::variants events;
+
+   if( _slots )
+   {
+      uint64_t end = _next.load( std::memory_order_acquire );
+      uint64_t start = end > _capacity ? end - _capacity : 0;
+      events.reserve( end - start );
+
+      for( uint64_t n = start; n < end; ++n )
+      {
+         const slot& s = _slots[ n % _capacity ];
+         uint64_t seq = s.seq.load( std::memory_order_acquire );
+         if( seq != 2 * n + 2 )
+            continue;
+
+         const char* name = s.name.load( std::memory_order_relaxed );
+         int64_t begin    = s.begin.load( std::memory_order_relaxed );
+         int64_t duration = s.duration.load( std::memory_order_relaxed );
+         int64_t arg      = s.arg.load( std::memory_order_relaxed );
+         uint32_t tid     = s.thread_id.load( std::memory_order_relaxed );
+
+         // The slot was claimed by a newer span while it was being copied
+         std::atomic_thread_fence( std::memory_order_acquire );
+         if( s.seq.load( std::memory_order_relaxed ) != seq )
+            continue;
+
+         fc::mutable_variant_object event;
+         event( "name", name )
+              ( "ph", "X" )
+              ( "ts", begin )
+              ( "dur", duration )
+              ( "pid", 1 )
+              ( "tid", tid );
+         if( arg >= 0 )
+            event( "args", fc::mutable_variant_object( "n", arg ) );
+         events.emplace_back( std::move( event ) );
+      }
+   }
+
+   return fc::mutable_variant_object( "traceEvents", std::move( events ) )( "displayTimeUnit", "ms" );
+}
+
+void tracer::write_chrome_trace( const fc::path& file )const
+{
+   fc::json::save_to_file( to_chrome_trace(), file, false );
+}
+
+} } // graphene::utilities
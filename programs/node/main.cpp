@@ -206,6 +206,22 @@ int main(int argc, char** argv) {
          exit_promise->set_value(signal);
       }, SIGTERM);
 
+#ifndef WIN32
+      // fc signal handlers fire once, so the dump handler re-registers itself
+      std::function< void( int ) > write_trace = [&]( int signal ) {
+         try
+         {
+            node->write_trace();
+         }
+         catch( const fc::exception& e )
+         {
+            elog( "Could not write trace: ${e}", ("e", e.to_detail_string()) );
+         }
+         fc::set_signal_handler( write_trace, SIGUSR2 );
+      };
+      fc::set_signal_handler( write_trace, SIGUSR2 );
+#endif
+
       node->chain_database()->with_read_lock( [&]()
       {
          ilog("Started witness node on a chain with ${h} blocks.", ("h", node->chain_database()->head_block_num()));
@@ -324,4 +324,35 @@ BOOST_AUTO_TEST_CASE( merkle_root )
    BOOST_CHECK( block.calculate_merkle_root() == c(dO) );
 }
 
+BOOST_AUTO_TEST_CASE( known_id_filter_test )
+{
+   known_id_filter filter( 100 );
+   auto id = []( uint32_t i ) { return fc::ripemd160::hash( std::to_string( i ) ); };
+
+   // nothing is covered before the first reset
+   BOOST_CHECK( !filter.excludes( id( 0 ), 0 ) );
+
+   filter.reset( 10 );
+   for( uint32_t i = 0; i < 100; ++i )
+      filter.insert( id( i ), 10 + i );
+
+   // no false negatives, and not covering what came before the reset
+   for( uint32_t i = 0; i < 100; ++i )
+      BOOST_CHECK( !filter.excludes( id( i ), 10 ) );
+   BOOST_CHECK( !filter.excludes( id( 1000 ), 9 ) );
+
+   uint32_t excluded = 0;
+   for( uint32_t i = 1000; i < 2000; ++i )
+      excluded += filter.excludes( id( i ), 10 );
+   BOOST_CHECK( excluded > 950 );
+
+   // filling a second generation drops the first one and the coverage moves up
+   for( uint32_t i = 100; i < 201; ++i )
+      filter.insert( id( i ), 10 + i );
+   BOOST_CHECK( filter.covered_from() == 111 );
+   BOOST_CHECK( !filter.excludes( id( 1000 ), 110 ) );
+   for( uint32_t i = 100; i < 201; ++i )
+      BOOST_CHECK( !filter.excludes( id( i ), 111 ) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
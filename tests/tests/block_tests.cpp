@@ -154,6 +154,63 @@ BOOST_AUTO_TEST_CASE( undo_block )
    }
 }
 
+BOOST_AUTO_TEST_CASE( reopen_restores_reversible_blocks )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate( fc::sha256::hash( string( "init_key" ) ) );
+
+      block_id_type head_id;
+      uint32_t head_num;
+      uint32_t lib;
+      signed_block minority_block;
+      {
+         database db;
+         db._log_hardforks = false;
+         db.open( data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+         for( uint32_t i = 0; i < 20; ++i )
+            db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+
+         // leave a block on a minority fork: pop it and build a longer branch next to it
+         minority_block = db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+         db.pop_block();
+         for( uint32_t i = 0; i < 2; ++i )
+            db.generate_block( db.get_slot_time(2), db.get_scheduled_witness(2), init_account_priv_key, database::skip_nothing );
+
+         head_id = db.head_block_id();
+         head_num = db.head_block_num();
+         lib = db.last_non_undoable_block_num();
+         BOOST_REQUIRE( lib < minority_block.block_num() );
+         BOOST_REQUIRE( db.head_block_id() != minority_block.id() );
+         BOOST_REQUIRE( db.fetch_block_by_id( minority_block.id() ).valid() );
+         db.close();
+      }
+      {
+         database db;
+         db._log_hardforks = false;
+         db.open( data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write );
+
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_num );
+         BOOST_CHECK( db.head_block_id() == head_id );
+         BOOST_CHECK_EQUAL( db.last_non_undoable_block_num(), lib );
+
+         // every reversible block is back in the fork database, including the minority fork
+         for( uint32_t num = lib + 1; num <= head_num; ++num )
+            BOOST_CHECK( db.fetch_block_by_number( num ).valid() );
+         BOOST_CHECK( db.fetch_block_by_id( minority_block.id() ).valid() );
+         BOOST_CHECK( !fc::exists( data_dir.path() / "fork_db" ) );
+
+         // and the chain carries on from there
+         auto b = db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing );
+         BOOST_CHECK( b.previous == head_id );
+         BOOST_CHECK_EQUAL( db.head_block_num(), head_num + 1 );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( fork_blocks )
 {
    try {
@@ -837,5 +894,141 @@ BOOST_FIXTURE_TEST_CASE( generate_block_size, clean_database_fixture )
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_FIXTURE_TEST_CASE( deferred_operation_handlers, clean_database_fixture )
+{
+   try
+   {
+      vector< transfer_operation > deferred_transfers;
+      db.subscribe_deferred_apply_operation( database::operation_tags< transfer_operation >(),
+         [&]( const operation_notification& note )
+         {
+            deferred_transfers.push_back( note.op.get< transfer_operation >() );
+         });
+
+      signed_transaction tx;
+      tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+
+      transfer_operation transfer;
+      transfer.from = genesisAccountBasename;
+      transfer.to = TEMP_ACCOUNT;
+      transfer.amount = asset( 1000, SYMBOL_COIN );
+      tx.operations.push_back( transfer );
+
+      transferTMEtoSCOREfund_operation score;
+      score.from = genesisAccountBasename;
+      score.to = genesisAccountBasename;
+      score.amount = asset( 1000, SYMBOL_COIN );
+      tx.operations.push_back( score );
+
+      transfer.amount = asset( 2000, SYMBOL_COIN );
+      tx.operations.push_back( transfer );
+
+      sign( tx, init_account_priv_key );
+      db.push_transaction( tx, 0 );
+
+      BOOST_REQUIRE_EQUAL( deferred_transfers.size(), 2 );
+      BOOST_REQUIRE( deferred_transfers[0].amount == asset( 1000, SYMBOL_COIN ) );
+      BOOST_REQUIRE( deferred_transfers[1].amount == asset( 2000, SYMBOL_COIN ) );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( get_recent_transaction, clean_database_fixture )
+{
+   try
+   {
+      vector< signed_transaction > trxs;
+      for( int i = 0; i < 3; ++i )
+      {
+         signed_transaction tx;
+         tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+
+         transfer_operation transfer;
+         transfer.from = genesisAccountBasename;
+         transfer.to = TEMP_ACCOUNT;
+         transfer.amount = asset( 1000 + i, SYMBOL_COIN );
+         tx.operations.push_back( transfer );
+
+         sign( tx, init_account_priv_key );
+         db.push_transaction( tx, 0 );
+         trxs.push_back( tx );
+      }
+
+      BOOST_TEST_MESSAGE( "--- Pending transactions are found at their place in the pending pool" );
+      for( const auto& tx : trxs )
+         BOOST_REQUIRE( db.get_recent_transaction( tx.id() ).id() == tx.id() );
+
+      BOOST_TEST_MESSAGE( "--- Transactions in a block are found at their place in it" );
+      generate_block();
+      BOOST_REQUIRE_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), trxs.size() );
+      for( const auto& tx : trxs )
+         BOOST_REQUIRE( db.get_recent_transaction( tx.id() ).id() == tx.id() );
+
+      REQUIRE_THROW( db.get_recent_transaction( transaction_id_type() ), fc::exception );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_FIXTURE_TEST_CASE( authority_change_within_block, clean_database_fixture )
+{
+   try
+   {
+      ACTORS( (alice) )
+      generate_block();
+
+      fc::ecc::private_key new_key = generate_private_key( "alice_new" );
+      fc::ecc::private_key newer_key = generate_private_key( "alice_newer" );
+
+      auto change_active_key = [&]( const fc::ecc::private_key& signing_key, const fc::ecc::private_key& new_active_key )
+      {
+         accountUpdate_operation op;
+         op.account = "alice";
+         op.active = authority( 1, new_active_key.get_public_key(), 1 );
+         op.memoKey = alice_public_key;
+
+         signed_transaction tx;
+         tx.operations.push_back( op );
+         tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+         tx.sign( signing_key, db.get_chain_id() );
+         return tx;
+      };
+      auto update_json = [&]( const fc::ecc::private_key& signing_key, const string& json )
+      {
+         accountUpdate_operation op;
+         op.account = "alice";
+         op.memoKey = alice_public_key;
+         op.json = json;
+
+         signed_transaction tx;
+         tx.operations.push_back( op );
+         tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+         tx.sign( signing_key, db.get_chain_id() );
+         return tx;
+      };
+
+      BOOST_TEST_MESSAGE( "--- A transaction signed with the new active key after the change in the same block is accepted" );
+      db.push_transaction( change_active_key( alice_private_key, new_key ), 0 );
+      db.push_transaction( update_json( new_key, "{\"n\":1}" ), 0 );
+      generate_block();
+      BOOST_REQUIRE_EQUAL( db.fetch_block_by_number( db.head_block_num() )->transactions.size(), 2 );
+      BOOST_REQUIRE( db.get< account_authority_object, by_account >( "alice" ).active == authority( 1, new_key.get_public_key(), 1 ) );
+
+      BOOST_TEST_MESSAGE( "--- A block with a transaction signed with the replaced active key after the change is rejected" );
+      block_id_type head_id = db.head_block_id();
+      db.push_transaction( change_active_key( new_key, newer_key ), 0 );
+      db.push_transaction( update_json( new_key, "{\"n\":2}" ), database::skip_transaction_signatures | database::skip_authority_check );
+      generate_block( database::skip_transaction_signatures | database::skip_authority_check );
+      signed_block bad_block = *db.fetch_block_by_number( db.head_block_num() );
+      BOOST_REQUIRE_EQUAL( bad_block.transactions.size(), 2 );
+
+      db.pop_block();
+      db.clear_pending();
+      BOOST_REQUIRE( db.head_block_id() == head_id );
+      REQUIRE_THROW( db.push_block( bad_block, database::skip_nothing ), fc::exception );
+      BOOST_REQUIRE( db.head_block_id() == head_id );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
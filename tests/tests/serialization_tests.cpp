@@ -27,6 +27,9 @@
 #include <node/chain/node_objects.hpp>
 #include <node/chain/database.hpp>
 
+#include <graphene/net/core_messages.hpp>
+#include <graphene/utilities/tempdir.hpp>
+
 #include <fc/crypto/digest.hpp>
 #include <fc/crypto/elliptic.hpp>
 #include <fc/reflect/variant.hpp>
@@ -324,6 +327,120 @@ BOOST_AUTO_TEST_CASE( hardfork_version_test )
    FC_LOG_AND_RETHROW();
 }
 
+BOOST_AUTO_TEST_CASE( prepared_transaction_test )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      transfer_operation op;
+      op.from = "alice";
+      op.to = "bob";
+      op.amount = asset(100,SYMBOL_COIN);
+
+      signed_transaction tx;
+      tx.operations.push_back( op );
+      tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+      tx.sign( alice_private_key, db.get_chain_id() );
+      tx.sign( bob_private_key, db.get_chain_id() );
+
+      prepared_transaction ptx( tx );
+      BOOST_REQUIRE( ptx.packed() == fc::raw::pack( tx ) );
+      BOOST_REQUIRE( ptx.pack_size() == fc::raw::pack_size( tx ) );
+      BOOST_REQUIRE( ptx.id() == tx.id() );
+      BOOST_REQUIRE( ptx.digest() == tx.digest() );
+      BOOST_REQUIRE( ptx.sig_digest( db.get_chain_id() ) == tx.sig_digest( db.get_chain_id() ) );
+      BOOST_REQUIRE( ptx.merkle_digest() == tx.merkle_digest() );
+      BOOST_REQUIRE( ptx.signature_keys( db.get_chain_id() ) == tx.get_signature_keys( db.get_chain_id() ) );
+
+      auto borrowed = prepared_transaction::borrow( tx );
+      BOOST_REQUIRE( &borrowed.get() == &tx );
+      BOOST_REQUIRE( borrowed.id() == ptx.id() );
+
+      tx.signatures.push_back( tx.signatures[0] );
+      REQUIRE_THROW( prepared_transaction( tx ).signature_keys( db.get_chain_id() ), tx_duplicate_sig );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE( packed_block_test )
+{
+   try
+   {
+      ACTORS( (alice)(bob) )
+      fund( "alice", 10000 );
+      // blocks are then packed from their prepared transactions on their way to the block log
+      db.set_block_signature_threads( 2 );
+
+      for( int i = 0; i < 3; ++i )
+      {
+         transfer_operation op;
+         op.from = "alice";
+         op.to = "bob";
+         op.amount = asset( 100 + i, SYMBOL_COIN );
+         op.memo = string( i * 10, 'x' );
+
+         signed_transaction tx;
+         tx.operations.push_back( op );
+         tx.operations.push_back( op );
+         tx.set_expiration( db.head_block_time() + MAX_TIME_UNTIL_EXPIRATION );
+         tx.sign( alice_private_key, db.get_chain_id() );
+         db.push_transaction( tx, 0 );
+      }
+      generate_block();
+
+      signed_block b = *db.fetch_block_by_number( db.head_block_num() );
+      BOOST_REQUIRE_EQUAL( b.transactions.size(), 3 );
+      vector< char > packed = fc::raw::pack( b );
+
+      BOOST_TEST_MESSAGE( "--- The view agrees with the decoded block" );
+      signed_block_view view( packed );
+      BOOST_REQUIRE( view.id() == b.id() );
+      BOOST_REQUIRE_EQUAL( view.block_num(), b.block_num() );
+      BOOST_REQUIRE_EQUAL( view.transaction_count(), b.transactions.size() );
+      // ask for them back to front, so locating a transaction has to decode the ones in front of it
+      for( int i = int( b.transactions.size() ) - 1; i >= 0; --i )
+      {
+         auto trx_data = view.transaction_data( i );
+         BOOST_REQUIRE( vector< char >( trx_data.first, trx_data.first + trx_data.second ) == fc::raw::pack( b.transactions[i] ) );
+         BOOST_REQUIRE( view.transaction( i ).id() == b.transactions[i].id() );
+         BOOST_REQUIRE_EQUAL( view.operation_count( i ), b.transactions[i].operations.size() );
+         BOOST_REQUIRE( view.operation_at( i, 1 ).get< transfer_operation >().amount == b.transactions[i].operations[1].get< transfer_operation >().amount );
+      }
+      BOOST_REQUIRE( fc::raw::pack( view.unpack() ) == packed );
+
+      BOOST_TEST_MESSAGE( "--- Framing the packed block gives the bytes of a block_message" );
+      graphene::net::message framed = graphene::net::packed_block_message( packed, b.id() );
+      graphene::net::message expected( graphene::net::block_message( b ) );
+      BOOST_REQUIRE_EQUAL( framed.msg_type, expected.msg_type );
+      BOOST_REQUIRE_EQUAL( framed.size, expected.size );
+      BOOST_REQUIRE( framed.data == expected.data );
+      BOOST_REQUIRE( framed.id() == expected.id() );
+      BOOST_REQUIRE( graphene::net::block_message_id( framed ) == b.id() );
+
+      BOOST_TEST_MESSAGE( "--- The block log returns the packed bytes of head and non-head blocks" );
+      fc::temp_directory log_dir( graphene::utilities::temp_directory_path() );
+      block_log log;
+      log.open( log_dir.path() / "block_log" );
+      for( uint32_t num = 1; num <= db.head_block_num(); ++num )
+         log.append( *db.fetch_block_by_number( num ) );
+      log.flush();
+
+      BOOST_REQUIRE( log.read_block_bytes_by_num( b.block_num() ) == packed );
+      BOOST_REQUIRE( log.read_block_bytes_by_num( b.block_num() - 1 ) == fc::raw::pack( *db.fetch_block_by_number( b.block_num() - 1 ) ) );
+      BOOST_REQUIRE( log.read_block_bytes_by_num( 1 ) == fc::raw::pack( *db.fetch_block_by_number( 1 ) ) );
+      BOOST_REQUIRE( log.read_block_bytes_by_num( b.block_num() + 1 ).empty() );
+
+      BOOST_TEST_MESSAGE( "--- Bytes packed from the prepared transactions are the bytes of the block" );
+      BOOST_REQUIRE( *db.fetch_block_bytes_by_number( b.block_num() ) == packed );
+      BOOST_REQUIRE( *db.fetch_block_bytes_by_id( b.id() ) == packed );
+      // once two blocks past irreversible the block is out of the fork database and read back from the block log
+      while( db.last_non_undoable_block_num() < b.block_num() + 2 )
+         generate_block();
+      BOOST_REQUIRE( *db.fetch_block_bytes_by_number( b.block_num() ) == packed );
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( min_block_size )
 {
    signed_block b;